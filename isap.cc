@@ -2,49 +2,811 @@
 #include <iostream>
 #include <queue>
 #include <vector>
+#include <limits>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <thread>
+#if defined(__x86_64__) && !defined(ISAP_NO_SIMD)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
+// Work counters for IsapStats; compiled out unless ISAP_STATS is defined.
+#ifdef ISAP_STATS
+#define ISAP_COUNT(statement) statement
+#else
+#define ISAP_COUNT(statement)
+#endif
+
+/**
+ * @brief Formats the counters as a flat JSON object, for metrics pipelines.
+ */
+string IsapStats::to_json() const {
+    return "{\"augmentations\": " + to_string(augmentations) +
+           ", \"path_length\": " + to_string(path_length) +
+           ", \"advances\": " + to_string(advances) +
+           ", \"relabels\": " + to_string(relabels) +
+           ", \"relabel_arc_scans\": " + to_string(relabel_arc_scans) +
+           ", \"dead_arc_skips\": " + to_string(dead_arc_skips) +
+           ", \"gap_cutoffs\": " + to_string(gap_cutoffs) +
+           ", \"bfs_runs\": " + to_string(bfs_runs) +
+           ", \"bfs_ns\": " + to_string(bfs_ns) + "}";
+}
+
 /**
  * @brief Constructor for the Isap class.
- * @brief adj is the adjacency list representing the graph.
+ * @brief The graph is stored in compressed sparse row (CSR) form: the arcs of node u are offset[u] .. offset[u + 1] - 1.
+ *        Edges are collected by add_edge and frozen into the CSR arrays on the next call to isap(), so the solver
+ *        walks contiguous memory instead of one heap block per node.
+ *        Each arc keeps only its head, its residual capacity (cap - flow) and its reverse arc, in separate arrays,
+ *        so the advance loop reads 8 bytes per arc; the flow of an edge is recovered from its capacity and residual.
  *        level is the distance label of each node from the sink node in the residual graph.
  *        gap is an array that stores the number of nodes at each level.
  * @brief In the context of network flow algorithms like ISAP, the "residual graph" is a graph that represents the remaining capacity along the edges of the original graph after some flow has been pushed through.
  *        It contains the same vertices as the original graph but has modified edges. Each edge in the residual graph represents either the remaining capacity along an original edge, or the ability to "undo" flow along that edge.
  *        The residual graph is used to determine if there is still a path to push more flow through, and it is updated after each flow push.
+ * @brief Cap is the type of capacities and of the flow value; Res is the type each arc's residual is stored in.
+ *        Res defaults to Cap. A narrower Res (e.g. uint32_t with Cap = long long) halves the residual array when
+ *        every single capacity is known to fit in it, while the total flow is still accumulated in Cap.
+ *        A capacity above the largest Res is stored as that largest Res (see to_res), which is all one arc can carry.
  * @param n The number of nodes in the graph.
+ * @param expected_edges The number of edges expected, reserved up front, see reserve().
+ */
+template <typename Cap, typename Res>
+BasicIsap<Cap, Res>::BasicIsap(int n, int expected_edges)
+    : built(false), bounds_violated(false), return_edge(-1), offset(n + 1, 0), node_order(NodeOrder::Given), order_root(0), augment_mode(AugmentMode::Retreat),
+      arc_partitioning(false), capacity_scaling(false), progress(nullptr) {
+    this->n = n;
+    ws.level.resize(n);
+    ws.gap.resize(n + 2);
+    reserve(expected_edges);
+}
+
+/**
+ * @brief Reserves storage for edges edges in total, so that neither add_edge nor the CSR build reallocates.
+ * @note All storage is a fixed set of flat arrays, whatever the graph; there are no per-node allocations to grow or free.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::reserve(int edges) {
+    edge_from.reserve(edges);
+    edge_to.reserve(edges);
+    edge_cap.reserve(edges);
+    edge_arc.reserve(edges);
+    head.reserve(2 * edges);
+    rev.reserve(2 * edges);
+    ws.res.reserve(2 * edges);
+}
+
+/**
+ * @brief Removes all edges and makes the graph n empty nodes, keeping the allocated storage for the next graph.
+ *        A solver reused this way through many short-lived solves allocates only when a graph outgrows all before it.
+ *        The policies, the node order included, and the statistics are kept.
+ * @note Time Complexity: O(V).
  */
-Isap::Isap(int n) : adj(n), level(n), gap(n) {
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::clear(int n) {
     this->n = n;
+    built = false;
+    touched.clear();
+    edge_from.clear();
+    edge_to.clear();
+    edge_cap.clear();
+    edge_cost.clear();
+    edge_lower.clear();
+    demand.clear();
+    bounds_violated = false;
+    return_edge = -1;
+    edge_arc.clear();
+    node_pos.clear();
+    node_id.clear();
+    head.clear();
+    rev.clear();
+    ws.res.clear();
+    offset.assign(n + 1, 0);
+    ws.level.assign(n, 0);
+    ws.gap.assign(n + 2, 0);
+    ws.labels_valid = false;
+    ws.label_sink = -1;
+    ws.cut_sources.clear();
+    ws.cut_level = 0;
 }
 
 /**
  * @brief Adds an edge from node u to node v with the given capacity. Also creates a reverse edge with capacity 0.
+ * @note Edges may be added after a call to isap(); the flow found so far is kept when the graph is rebuilt,
+ *       and augment() continues from it.
  * @param u The source node.
  * @param v The destination node.
  * @param cap The capacity of the edge.
+ * @return The id of the edge, to be passed to get_edge.
+ */
+template <typename Cap, typename Res>
+int BasicIsap<Cap, Res>::add_edge(int u, int v, Cap cap) {
+    edge_from.push_back(u);
+    edge_to.push_back(v);
+    edge_cap.push_back(to_res(cap));
+    built = false;
+    if (ws.labels_valid) touched.push_back(edge_from.size() - 1);
+    return edge_from.size() - 1;
+}
+
+/**
+ * @brief Converts a capacity to the residual type. A Res narrower than Cap cannot hold every capacity: a larger one is
+ *        clamped to the largest Res instead of being truncated, so that it stays at least as large as any flow an arc
+ *        can carry, e.g. an infinite capacity stays effectively infinite.
+ */
+template <typename Cap, typename Res>
+Res BasicIsap<Cap, Res>::to_res(Cap cap) {
+    return cap > (Cap)numeric_limits<Res>::max() ? numeric_limits<Res>::max() : (Res)cap;
+}
+
+/**
+ * @brief Adds an edge with a cost per unit of flow, for min_cost_flow(). The max-flow solvers ignore costs, so one
+ *        graph serves both.
+ * @param cost The cost of one unit of flow on the edge; the reverse arc has cost -cost.
+ * @return The id of the edge, to be passed to get_edge.
+ */
+template <typename Cap, typename Res>
+int BasicIsap<Cap, Res>::add_edge(int u, int v, Cap cap, CostType<Cap> cost) {
+    int id = add_edge(u, v, cap);
+    edge_cost.resize(id + 1, 0);
+    edge_cost[id] = cost;
+    return id;
+}
+
+/**
+ * @brief Adds an edge whose flow must lie between lower and upper, for feasible_flow(). Only upper - lower is stored
+ *        as the capacity of the edge, and the lower bound is folded into the demands of its endpoints, so a network
+ *        with lower bounds takes no more memory than one without.
+ * @note The other solvers, set_capacity() and apply_updates() see the edge as one of capacity upper - lower on top of
+ *       the lower bound; get_edge() reports the bounds and the flow with the lower bound included.
+ * @param lower The minimum flow on the edge.
+ * @param upper The maximum flow on the edge.
+ * @return The id of the edge, to be passed to get_edge.
+ */
+template <typename Cap, typename Res>
+int BasicIsap<Cap, Res>::add_bounded_edge(int u, int v, Cap lower, Cap upper) {
+    int id = add_edge(u, v, max(upper - lower, (Cap)0));
+    bounds_violated |= lower > upper;
+    edge_lower.resize(id + 1, 0);
+    edge_lower[id] = lower;
+    if (demand.empty()) demand.assign(n, 0);
+    demand[u] -= lower;
+    demand[v] += lower;
+    return id;
+}
+
+/**
+ * @brief Returns the number of edges added so far.
+ */
+template <typename Cap, typename Res>
+int BasicIsap<Cap, Res>::edge_count() const {
+    return edge_from.size();
+}
+
+/**
+ * @brief Returns the edge with the given id, together with the flow currently routed through it.
+ * @param id The id returned by add_edge.
+ */
+template <typename Cap, typename Res>
+BasicEdge<Cap> BasicIsap<Cap, Res>::get_edge(int id) const {
+    CostType<Cap> cost = id < (int)edge_cost.size() ? edge_cost[id] : 0;
+    Cap lower = id < (int)edge_lower.size() ? edge_lower[id] : 0;
+    if (id >= (int)edge_arc.size()) {
+        return {edge_to[id], lower + (Cap)edge_cap[id], lower, -1, cost};
+    }
+    int a = edge_arc[id];
+    return {edge_to[id], lower + (Cap)edge_cap[id], lower + (Cap)edge_cap[id] - ws.res[a], rev[a], cost};
+}
+
+/**
+ * @brief Removes all flow from the graph in place, so the next isap() call solves from scratch without rebuilding.
+ * @note Time Complexity: O(E).
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::reset_flows() {
+    for (int i = 0; i < (int)edge_arc.size(); i++) {
+        ws.res[edge_arc[i]] = edge_cap[i];
+        ws.res[rev[edge_arc[i]]] = 0;
+    }
+    ws.labels_valid = false;
+    ws.live_end.clear();
+}
+
+/**
+ * @brief Changes the capacity of an added edge, keeping the flow currently routed through it.
+ * @note The flow on the edge must not exceed the new capacity; call reset_flows() first to lower it further.
+ *       After an increase, augment() routes only the additional flow.
+ * @param id The id returned by add_edge.
+ * @param cap The new capacity of the edge.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::set_capacity(int id, Cap cap) {
+    Res c = to_res(cap);
+    if (id < (int)edge_arc.size()) {
+        int a = edge_arc[id];
+        ws.res[a] = c - (edge_cap[id] - ws.res[a]);
+        mark_stale(a);
+    }
+    edge_cap[id] = c;
+    if (ws.labels_valid) touched.push_back(id);
+}
+
+/**
+ * @brief Deactivates an added edge in place: its capacity becomes 0 and the flow routed through it is dropped.
+ *        The CSR arrays are not rebuilt and edge ids stay the same.
+ * @note Dropping a flow f on an edge (u, v) leaves u with f units more inflow than outflow and v with f units less.
+ *       Removing a (t, s) return edge this way turns a circulation into an s-t flow of value f, which augment() can
+ *       then enlarge. Removal only deletes residual arcs, so the distance
+ *       labels stay valid and augment() keeps its warm start.
+ * @param id The id returned by add_edge.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::remove_edge(int id) {
+    if (id < (int)edge_arc.size()) {
+        int a = edge_arc[id];
+        ws.res[a] = 0;
+        ws.res[rev[a]] = 0;
+        mark_stale(a);
+    }
+    edge_cap[id] = 0;
+    // Not a residual increase, but the labels no longer describe the cut of the current flow.
+    if (ws.labels_valid) touched.push_back(id);
+}
+
+/**
+ * @brief Sets when the ISAP loop runs a global relabel, see GlobalRelabelPolicy. By default it never does.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::set_global_relabel_policy(const GlobalRelabelPolicy& policy) {
+    relabel_policy = policy;
+}
+
+/**
+ * @brief Returns how many global relabels the ISAP loop has run, over all solves so far.
+ *        The initial BFS of isap() is not counted.
+ */
+template <typename Cap, typename Res>
+long long BasicIsap<Cap, Res>::global_relabel_count() const {
+    return ws.global_relabels;
+}
+
+/**
+ * @brief Returns the work counters of the ISAP loop, see IsapStats.
+ */
+template <typename Cap, typename Res>
+const IsapStats& BasicIsap<Cap, Res>::stats() const {
+    return ws.counters;
+}
+
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::reset_stats() {
+    ws.counters = IsapStats();
+}
+
+/**
+ * @brief Returns whether isap.cc was compiled with ISAP_STATS, i.e. whether stats() counts anything.
+ */
+template <typename Cap, typename Res>
+bool BasicIsap<Cap, Res>::stats_enabled() {
+#ifdef ISAP_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Sets how the ISAP loop continues after an augmentation, see AugmentMode. The default is AugmentMode::Retreat.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::set_augment_mode(AugmentMode mode) {
+    augment_mode = mode;
+}
+
+/**
+ * @brief Sets how the nodes are numbered internally, see NodeOrder. The default is NodeOrder::Given.
+ *        Node ids arrive in whatever order the caller assigns, so the label reads level[head[a]] of bfs() and of the
+ *        ISAP loop jump across memory. A locality-preserving numbering keeps the neighbours of a node, and thereby
+ *        their labels and arcs, close together. All methods still take and return the caller's node ids; only the
+ *        internal arrays are permuted.
+ * @note The order is computed on the next solve, which rebuilds the CSR arrays and starts without labels; the flow
+ *       is kept. It stays fixed while edges are added, and is recomputed after clear().
+ * @param order The numbering.
+ * @param root The node NodeOrder::Bfs starts from, typically the sink; NodeOrder::ReverseCuthillMcKee starts from it
+ *        too when it is given, and from a node of smallest degree otherwise (root < 0).
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::set_node_order(NodeOrder order, int root) {
+    node_order = order;
+    order_root = root;
+    node_pos.clear();
+    node_id.clear();
+    built = false;
+    touched.clear();
+    ws.labels_valid = false;
+    ws.label_sink = -1;
+    ws.cut_sources.clear();
+    ws.cut_level = 0;
+}
+
+/**
+ * @brief Sets whether isap() augments by capacity scaling. By default it does not.
+ *        With scaling, isap() runs in phases for delta = 2^k, 2^(k-1), ..., 2, where 2^k is the largest residual
+ *        rounded down to a power of two. Edges of capacity CapTraits<Cap>::inf(), such as super source and sink
+ *        arcs, do not count towards it: their residual stays above every delta, so they are admissible in every phase. A phase runs the ISAP loop with only arcs of residual at least delta counting
+ *        as admissible, on labels from a BFS over those arcs, until no such path is left; a final run then admits
+ *        every residual. When the phase for delta ends, less than E * delta flow is missing, so the next phase,
+ *        pushing at least delta / 2 per path, augments at most 2E times: O(E log U) augmentations for capacities up
+ *        to U, instead of runs of tiny augmentations through low-capacity arcs when capacities span a wide range.
+ *        Labels are recomputed for each phase: the arcs a phase admits anew can be shortcuts that leave the labels
+ *        of the previous phase above the distances.
+ * @note Proving that a phase has no path left takes relabels, and ISAP pays that once per phase instead of once, so
+ *       scaling pays off where augmentations dominate, i.e. long augmenting paths through a wide range of
+ *       capacities, and costs time where relabels do, e.g. on square grids or short bipartite paths. During the
+ *       phases a global relabel runs every n / 4 local relabels, on top of the GlobalRelabelPolicy.
+ * @note For floating-point residuals the phases stop at delta = 2^-32 times the largest residual.
+ *       The scaled phases scan arcs with the scalar loops; the final run uses the SIMD kernels as usual.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::set_capacity_scaling(bool enabled) {
+    capacity_scaling = enabled;
+}
+
+/**
+ * @brief Attaches a progress channel that isap(s, t) and augment() report to, or detaches it with nullptr. The
+ *        channel must outlive the solves; other threads may read it and set its cancel flag while they run.
+ *        Every 4096 steps the ISAP loop publishes the flow so far, the label of s and the number of nodes at it, and
+ *        checks cancel and the deadline. A solve told to stop returns the flow it has routed, which is a valid flow,
+ *        and sets stopped and an upper bound on the flow it could have routed: the flow plus the residual capacity
+ *        of the cheapest of the cuts {v : label(v) >= k}, 0 < k <= label(s), each of which holds s and no sink.
+ *        min_cut_source_side() then returns that cut. The labels stay valid, so augment() resumes the solve; with
+ *        capacity scaling, a solve stopped in a phase keeps the labels of the phase for the cut, and augment()
+ *        resumes from a BFS instead.
+ * @note Checking costs a few loads every 4096 steps and a clock read if there is a deadline; the bound is one pass
+ *       over the arcs, once a solve stops.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::set_progress(BasicSolveProgress<Cap>* progress) {
+    this->progress = progress;
+}
+
+/**
+ * @brief Resets the progress channel, if any, for a solve on ws starting now.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::begin_progress() {
+    ws.watch = progress;
+    if (!progress) return;
+    progress->nodes.store(n, memory_order_relaxed);
+    progress->flow.store(0, memory_order_relaxed);
+    progress->source_level.store(0, memory_order_relaxed);
+    progress->source_level_nodes.store(0, memory_order_relaxed);
+    progress->upper_bound.store(CapTraits<Cap>::inf(), memory_order_relaxed);
+    progress->stopped.store(false, memory_order_relaxed);
+    progress->done.store(false, memory_order_release);
+}
+
+/**
+ * @brief Publishes the result flow of the solve on ws and returns it.
+ */
+template <typename Cap, typename Res>
+Cap BasicIsap<Cap, Res>::finish_progress(Cap flow) {
+    ws.watch = nullptr;
+    if (!progress) return flow;
+    progress->flow.store(flow, memory_order_relaxed);
+    if (!progress->stopped.load(memory_order_relaxed)) progress->upper_bound.store(flow, memory_order_relaxed);
+    progress->done.store(true, memory_order_release);
+    return flow;
+}
+
+/**
+ * @brief The smallest residual capacity of a cut {v : w.level[v] >= k} for 0 < k <= w.level[s], which is at least the
+ *        flow still missing from s; w.cut_level is set to the k that attains it.
+ *        An arc from u to v crosses the cuts for level[v] < k <= level[u], so one pass adds every arc to a range of
+ *        cuts through a difference array. No validity of the labels is assumed, so the labels of a scaling phase do.
+ */
+template <typename Cap, typename Res>
+Cap BasicIsap<Cap, Res>::cut_bound(Workspace& w, int s) const {
+    int top = w.level[s];
+    // Wide enough that the sums of residuals on any cut are exact.
+    vector<long double> diff(top + 2, 0);
+    for (int u = 0; u < n; u++) {
+        int hi = min(w.level[u], top);
+        for (int a = offset[u]; a < offset[u + 1]; a++) {
+            int lo = w.level[head[a]];
+            if (w.res[a] > 0 && lo < hi) {
+                diff[lo + 1] += w.res[a];
+                diff[hi + 1] -= w.res[a];
+            }
+        }
+    }
+    long double best = CapTraits<Cap>::inf(), cut = 0;
+    for (int k = 1; k <= top; k++) {
+        cut += diff[k];
+        if (cut < best) {
+            best = cut;
+            w.cut_level = k;
+        }
+    }
+    return (Cap)best;
+}
+
+/**
+ * @brief Sets whether isap() and augment() keep the saturated arcs of every node behind its live arcs. By default
+ *        they do not.
+ *        Every edge adds a reverse arc without residual, and the arcs a solve saturates stay in the scans of the
+ *        ISAP loop: an advance that finds no admissible arc reads the dead arcs after its current arc, and the relabel
+ *        that follows reads all of them again. With partitioning, a solve first moves the arcs of each node with a
+ *        residual to the front of its range (O(E)). Afterwards, an augmentation swaps each arc it saturates behind
+ *        the live range and each reverse arc it revives into it, so advances and relabels stop at the end of the live
+ *        range. The saved scans are counted in IsapStats::dead_arc_skips.
+ *        The partition is kept between solves: set_capacity(), remove_edge() and apply_updates() mark the nodes whose
+ *        arcs they change, and the next solve repartitions only those, so augment() stays proportional to the change.
+ *        A rebuild, reset_flows() and the other engines drop the partition, and the next solve makes it anew.
+ * @note The arcs of a node are reordered in place, so get_edge(id).rev may change between solves; edge ids do not.
+ *       max_flow_batch() and the other engines read the arcs in whatever order they are and do not partition.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::set_arc_partitioning(bool enabled) {
+    arc_partitioning = enabled;
+    ws.live_end.clear();
+    ws.arc_edge.clear();
+}
+
+/**
+ * @brief Exchanges the arcs at positions p and q of the same node, with their heads, residuals and edges, and points
+ *        their reverse arcs at their new positions.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::swap_arcs(Workspace& w, int p, int q) {
+    swap(head[p], head[q]);
+    swap(w.res[p], w.res[q]);
+    swap(w.arc_edge[p], w.arc_edge[q]);
+    // The reverse arcs of a self-loop are each other and keep pointing at each other's new position.
+    if (rev[p] != q) {
+        swap(rev[p], rev[q]);
+        rev[rev[p]] = p;
+        rev[rev[q]] = q;
+    }
+    if (w.arc_edge[p] >= 0) edge_arc[w.arc_edge[p]] = p;
+    if (w.arc_edge[q] >= 0) edge_arc[w.arc_edge[q]] = q;
+}
+
+/**
+ * @brief Moves the arcs of each node with a residual in w in front of the saturated ones and sets w.live_end.
+ *        If w already holds a partition, only the nodes in w.stale are repartitioned.
+ * @note Time Complexity: O(V + E) for a new partition, O(the arcs of the stale nodes) otherwise.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::partition_arcs(Workspace& w) {
+    if (!w.live_end.empty()) {
+        for (int u : w.stale) partition_node(w, u);
+        w.stale.clear();
+        return;
+    }
+    w.stale.clear();
+    w.arc_edge.assign(head.size(), -1);
+    for (int id = 0; id < (int)edge_arc.size(); id++) {
+        w.arc_edge[edge_arc[id]] = id;
+    }
+    w.live_end.resize(n);
+    for (int u = 0; u < n; u++) {
+        partition_node(w, u);
+    }
+}
+
+/**
+ * @brief Moves the arcs of node u with a residual in w in front of its saturated ones and sets w.live_end[u].
+ *        Swaps only reorder the range of u, so the partitions of the other nodes stay as they are.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::partition_node(Workspace& w, int u) {
+    int i = offset[u], j = offset[u + 1] - 1;
+    while (i <= j) {
+        if (w.res[i] > 0) {
+            i++;
+        } else if (w.res[j] <= 0) {
+            j--;
+        } else {
+            swap_arcs(w, i++, j--);
+        }
+    }
+    w.live_end[u] = i;
+}
+
+/**
+ * @brief Records that arc a and its reverse arc changed residual outside the ISAP loop, so that the next solve
+ *        repartitions both of their tails.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::mark_stale(int a) {
+    if (ws.live_end.empty()) return;
+    ws.stale.push_back(head[rev[a]]);
+    ws.stale.push_back(head[a]);
+}
+
+/**
+ * @brief Maps the caller's node v to its internal number.
+ */
+template <typename Cap, typename Res>
+int BasicIsap<Cap, Res>::inner(int v) const {
+    return node_pos.empty() ? v : node_pos[v];
+}
+
+/**
+ * @brief Returns the source side S of a minimum s-t cut for the flow of the last isap() or augment() call.
+ *        S contains s, not t, and no residual arc leaves it, so the edges from S to the rest are saturated and their
+ *        capacities sum to the maximum flow. For a maximum weight closure, S without s is a closure of maximum weight.
+ *        After isap(sources, sinks), S contains no sink and every source that is not also a sink.
+ * @note While the graph is unchanged since the solve, S is read off the distance labels: it is every node whose label
+ *       is at or above an empty level, e.g. the one where the gap heuristic stopped. No graph traversal is needed.
+ *       After a change to the graph, S is the set of nodes reachable from the sources in the residual graph instead.
+ * @note Time Complexity: O(V) from the labels, O(V + E) otherwise.
+ */
+template <typename Cap, typename Res>
+vector<bool> BasicIsap<Cap, Res>::min_cut_source_side() const {
+    return cut_side(ws, built && touched.empty());
+}
+
+/**
+ * @brief The minimum cut of the last solve in workspace w, indexed by the caller's node ids.
+ *        unchanged tells whether the graph is as it was then.
+ */
+template <typename Cap, typename Res>
+vector<bool> BasicIsap<Cap, Res>::cut_side(const Workspace& w, bool unchanged) const {
+    vector<bool> side(n, false);
+    if (w.cut_sources.empty()) {
+        return side;
+    }
+    if (unchanged && w.labels_valid) {
+        int k = w.cut_level;
+        if (k == 0) {
+            k = 1;
+            while (w.gap[k] > 0) k++;
+        }
+        for (int v = 0; v < n; v++) {
+            side[node_id.empty() ? v : node_id[v]] = w.level[v] >= k;
+        }
+        return side;
+    }
+    queue<int> q;
+    for (int s : w.cut_sources) {
+        q.push(s);
+        side[s] = true;
+    }
+    while (!q.empty()) {
+        int u = q.front();
+        q.pop();
+        for (int i = offset[u]; i < offset[u + 1]; i++) {
+            if (!side[head[i]] && w.res[i] > 0) {
+                side[head[i]] = true;
+                q.push(head[i]);
+            }
+        }
+    }
+    if (!node_id.empty()) {
+        vector<bool> by_id(n);
+        for (int v = 0; v < n; v++) by_id[node_id[v]] = side[v];
+        side.swap(by_id);
+    }
+    return side;
+}
+
+/**
+ * @brief Returns the ids of the edges crossing the minimum cut given by min_cut_source_side().
+ */
+template <typename Cap, typename Res>
+vector<int> BasicIsap<Cap, Res>::min_cut_edges() const {
+    vector<bool> side = min_cut_source_side();
+    vector<int> cut;
+    for (int id = 0; id < (int)edge_from.size(); id++) {
+        if (side[edge_from[id]] && !side[edge_to[id]]) {
+            cut.push_back(id);
+        }
+    }
+    return cut;
+}
+
+/**
+ * @brief Computes node_id, the caller's node at each internal number, and node_pos for node_order, from the
+ *        undirected graph of the added edges. Nodes the order does not reach (other components) follow in the same
+ *        order from further roots.
+ * @note Time Complexity: O(V + E), plus O(E log E) for the degree sorts of NodeOrder::ReverseCuthillMcKee and
+ *       O(V log V) for NodeOrder::Degree.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::compute_node_order() {
+    int m = edge_from.size();
+    vector<int> start(n + 1, 0), adj(2 * m);
+    for (int i = 0; i < m; i++) {
+        start[edge_from[i] + 1]++;
+        start[edge_to[i] + 1]++;
+    }
+    for (int u = 0; u < n; u++) {
+        start[u + 1] += start[u];
+    }
+    vector<int> pos(start.begin(), start.end() - 1);
+    for (int i = 0; i < m; i++) {
+        adj[pos[edge_from[i]]++] = edge_to[i];
+        adj[pos[edge_to[i]]++] = edge_from[i];
+    }
+    auto degree = [&](int v) { return start[v + 1] - start[v]; };
+    node_id.clear();
+    node_id.reserve(n);
+    if (node_order == NodeOrder::Degree) {
+        for (int v = 0; v < n; v++) node_id.push_back(v);
+        stable_sort(node_id.begin(), node_id.end(), [&](int a, int b) { return degree(a) > degree(b); });
+    } else {
+        bool rcm = node_order == NodeOrder::ReverseCuthillMcKee;
+        if (rcm) {
+            for (int u = 0; u < n; u++) {
+                sort(adj.begin() + start[u], adj.begin() + start[u + 1],
+                     [&](int a, int b) { return degree(a) < degree(b); });
+            }
+        }
+        // Roots: the given one first, then the unvisited nodes, by increasing degree for Cuthill-McKee.
+        vector<int> roots;
+        if (order_root >= 0 && order_root < n) roots.push_back(order_root);
+        for (int v = 0; v < n; v++) roots.push_back(v);
+        if (rcm) {
+            stable_sort(roots.begin() + (order_root >= 0 && order_root < n), roots.end(),
+                        [&](int a, int b) { return degree(a) < degree(b); });
+        }
+        vector<char> seen(n, 0);
+        for (int root : roots) {
+            if (seen[root]) continue;
+            seen[root] = 1;
+            node_id.push_back(root);
+            for (int i = node_id.size() - 1; i < (int)node_id.size(); i++) {
+                int u = node_id[i];
+                for (int j = start[u]; j < start[u + 1]; j++) {
+                    if (!seen[adj[j]]) {
+                        seen[adj[j]] = 1;
+                        node_id.push_back(adj[j]);
+                    }
+                }
+            }
+        }
+        if (rcm) reverse(node_id.begin(), node_id.end());
+    }
+    node_pos.assign(n, 0);
+    for (int i = 0; i < n; i++) node_pos[node_id[i]] = i;
+}
+
+/**
+ * @brief Freezes the added edges into the CSR arrays, under the internal node numbers of node_order.
+ *        Arcs keep the per-node order add_edge would give with adjacency lists: the forward arc of an edge is placed
+ *        at the next free slot of its tail, the reverse arc at the next free slot of its head.
+ * @note Time Complexity: O(V + E), plus compute_node_order() on the first build under an order other than Given.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::build() {
+    int m = edge_from.size();
+    if (node_order != NodeOrder::Given && node_id.empty()) compute_node_order();
+    // The flow of the edges of the previous build, to carry over; the first build needs no copy.
+    vector<Res> flow;
+    if (!edge_arc.empty()) {
+        flow.assign(m, 0);
+        for (int i = 0; i < (int)edge_arc.size(); i++) {
+            flow[i] = edge_cap[i] - ws.res[edge_arc[i]];
+        }
+    }
+    fill(offset.begin(), offset.end(), 0);
+    for (int i = 0; i < m; i++) {
+        offset[inner(edge_from[i]) + 1]++;
+        offset[inner(edge_to[i]) + 1]++;
+    }
+    for (int u = 0; u < n; u++) {
+        offset[u + 1] += offset[u];
+    }
+    // The next free slot of each node, kept in the current-arc buffer so a rebuild does not allocate.
+    vector<int>& pos = ws.cur;
+    pos.assign(offset.begin(), offset.end() - 1);
+    head.resize(2 * m);
+    ws.res.resize(2 * m);
+    rev.resize(2 * m);
+    edge_arc.resize(m);
+    ws.live_end.clear();
+    for (int i = 0; i < m; i++) {
+        int u = inner(edge_from[i]), v = inner(edge_to[i]);
+        int a = pos[u]++;
+        int b = pos[v]++;
+        head[a] = v;
+        Res f = flow.empty() ? 0 : flow[i];
+        ws.res[a] = edge_cap[i] - f;
+        rev[a] = b;
+        head[b] = u;
+        ws.res[b] = f;
+        rev[b] = a;
+        edge_arc[i] = a;
+    }
+    built = true;
+}
+
+/**
+ * @brief Computes exact distance labels to the sink t in the residual graph.
+ *        Nodes that cannot reach t get level n, which keeps every label a valid lower bound.
  */
-void Isap::add_edge(int u, int v, int cap) {
-    adj[u].push_back({v, cap, 0, (int)adj[v].size()});
-    adj[v].push_back({u, 0, 0, (int)adj[u].size() - 1});
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::bfs(Workspace& w, int t) const {
+    w.sinks.assign(1, t);
+    bfs(w);
+}
+
+/**
+ * @brief Computes exact distance labels to the nearest node of w.sinks, all of which get level 0, with one
+ *        breadth-first search from all of them at once.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::bfs(Workspace& w) const {
+    ISAP_COUNT(auto start = chrono::steady_clock::now());
+    fill(w.level.begin(), w.level.end(), n);
+    fill(w.gap.begin(), w.gap.end(), 0);
+    queue<int> q;
+    int reached = 0;
+    for (int t : w.sinks) {
+        if (w.level[t] == 0) continue;
+        q.push(t);
+        w.level[t] = 0;
+        w.gap[0]++;
+        reached++;
+    }
+    while (!q.empty()) {
+        int u = q.front();
+        q.pop();
+        for (int i = offset[u]; i < offset[u + 1]; i++) {
+            int v = head[i];
+            if (w.level[v] == n && w.res[rev[i]] > 0 && w.res[rev[i]] >= w.delta) {
+                w.level[v] = w.level[u] + 1;
+                w.gap[w.level[v]]++;
+                reached++;
+                q.push(v);
+            }
+        }
+    }
+    w.gap[n] = n - reached;
+    ISAP_COUNT(w.counters.bfs_runs++);
+    ISAP_COUNT(w.counters.bfs_ns += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+    w.labels_valid = true;
+    w.phase_labels = false;
+    w.label_sink = w.sinks.size() == 1 ? w.sinks[0] : -1;
 }
 
-void Isap::bfs(int t) {
-    fill(level.begin(), level.end(), -1);
-    fill(gap.begin(), gap.end(), 0);
+/**
+ * @brief Restores valid labels after the edges in touched, and the arcs in grown, gained residual capacity, without a
+ *        full BFS. The labels are valid when level[u] <= level[v] + 1 for every residual arc (u, v). An arc that breaks
+ *        this lowers level[u] to level[v] + 1, and the decrease is propagated backwards over residual arcs, so the work
+ *        is proportional to the part of the graph whose labels actually change.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::repair_labels(const vector<int>& grown) {
     queue<int> q;
-    q.push(t);
-    level[t] = 0;
-    gap[0] = 1;
+    auto check = [&](int a) {
+        int u = head[rev[a]], v = head[a];
+        if (ws.res[a] > 0 && ws.level[u] > ws.level[v] + 1) {
+            ws.gap[ws.level[u]]--;
+            ws.gap[ws.level[u] = ws.level[v] + 1]++;
+            q.push(u);
+        }
+    };
+    for (int id : touched) check(edge_arc[id]);
+    for (int a : grown) check(a);
+    touched.clear();
     while (!q.empty()) {
         int u = q.front();
         q.pop();
-        for (auto& e : adj[u]) {
-            int v = e.to;
-            if (level[v] == -1 && adj[v][e.rev].cap > adj[v][e.rev].flow) {
-                level[v] = level[u] + 1;
-                gap[level[v]]++;
+        for (int i = offset[u]; i < offset[u + 1]; i++) {
+            int v = head[i];
+            if (ws.res[rev[i]] > 0 && ws.level[v] > ws.level[u] + 1) {
+                ws.gap[ws.level[v]]--;
+                ws.gap[ws.level[v] = ws.level[u] + 1]++;
                 q.push(v);
             }
         }
@@ -56,12 +818,12 @@ void Isap::bfs(int t) {
  * @note Time Complexity: O(V^2 * E) where V is the number of vertices and E is the number of edges.
  *       ISAP tends to be slightly faster than a standard Dinic implementation. It tends to have lower constant factors, avoids the overhead of repeated BFS phases, and its gap heuristic is highly effective. 
  *       Dinic has better proven complexity bounds on specific graph types, like unit capacity networks (O(min(V^(2/3), E^(1/2)) * E)).
- * @note Space Complexity: O(V + E) due to storing adjacency lists and level/gap arrays.
+ * @note Space Complexity: O(V + E) due to storing the CSR arrays and level/gap arrays.
  *       In the worst case, O(E) for storing the edges.
  * 
  * @param s The source node.
  * @param t The sink node.
- * @return The maximum flow from s to t.
+ * @return The maximum flow from s to t, on top of any flow already in the graph.
  *
  * @note This algorithm can be used for solving Directed Graph Maximum Weight Closure.
  *       Let G = (V, E) be a directed graph with weights w(v) on the vertices, where w(v) can be positive or negative.
@@ -81,64 +843,796 @@ void Isap::bfs(int t) {
  *       7. The maximum closure weight is W_pos - F.
  *       8. The maximum weight closure is all the vertices that can be reachable from s, in the residual graph.
  */
-int Isap::isap(int s, int t) {
+template <typename Cap, typename Res>
+Cap BasicIsap<Cap, Res>::isap(int s, int t) {
+    if (!built) build();
+    s = inner(s);
+    t = inner(t);
+    begin_progress();
     // Compute distance labels using BFS from the sink
-    bfs(t);
+    bfs(ws, t);
+    touched.clear();
+    if (arc_partitioning) partition_arcs(ws);
+    if (!capacity_scaling) return finish_progress(run(ws, s));
+    // The largest finite residual: the forward arcs of infinite edges would start the phases near the top of Res.
+    Res top = 0, inf = to_res(CapTraits<Cap>::inf());
+    for (int id = 0; id < (int)edge_arc.size(); id++) {
+        int a = edge_arc[id];
+        if (edge_cap[id] < inf) top = max(top, ws.res[a]);
+        top = max(top, ws.res[rev[a]]);
+    }
+    // Phases for delta = the largest power of two up to top, halved down to 2 (or top / 2^32 for floating-point
+    // residuals), each on labels from a BFS over the arcs with at least delta; a final run admits every residual.
+    Res last = numeric_limits<Res>::is_integer ? (Res)2 : (Res)(top / 4294967296.0);
+    Cap flow = 0;
+    if (top >= last && top > 0) {
+        for (Res delta = (Res)exp2(floor(log2((double)top))); delta >= last && delta > 0; delta /= 2) {
+            ws.delta = delta;
+            bfs(ws, t);
+            flow += run(ws, s);
+            if (progress && progress->stopped.load(memory_order_relaxed)) {
+                // The labels only describe the arcs of the phase, so a later augment() starts from a BFS.
+                ws.delta = 0;
+                ws.phase_labels = true;
+                return finish_progress(flow);
+            }
+            // The next run publishes its flow on top of that of the phases so far.
+            if (progress) progress->flow.store(flow, memory_order_relaxed);
+        }
+        ws.delta = 0;
+        bfs(ws, t);
+    }
+    return finish_progress(flow + run(ws, s));
+}
+
+/**
+ * @brief Calculates the maximum flow from a set of sources to a set of sinks, as from a super source joined to every
+ *        source to a super sink joined from every sink, without adding those nodes and their arcs to the graph.
+ *        The labels are distances to the nearest sink, from one BFS started at all sinks, so no hub node widens the
+ *        BFS or holds a level of its own, and no infinite capacity is needed that could overflow Cap.
+ *        The ISAP loop then runs from each source in turn on the same labels; an augmenting path ends at the first
+ *        sink it reaches. Once a source has no augmenting path left, pushing flow from the later sources cannot
+ *        create one, so the flow is maximum after one pass over the sources.
+ * @note The labels are recomputed at the end, so min_cut_source_side() reads the cut off them: the nodes that
+ *       cannot reach a sink.
+ * @note Capacity scaling and the progress channel apply to isap(s, t) only: this overload always runs the plain ISAP
+ *       loop, does not publish progress and cannot be cancelled. Pass a single source and sink to isap(s, t) for them.
+ * @note Time Complexity: as isap(), plus one BFS. The current arcs are kept from one source to the next.
+ * @param sources The source nodes. A node that is also a sink contributes no flow and is on the sink side of the cut.
+ * @param sinks The sink nodes.
+ * @return The maximum flow from the sources to the sinks, on top of any flow already in the graph.
+ */
+template <typename Cap, typename Res>
+Cap BasicIsap<Cap, Res>::isap(const vector<int>& sources, const vector<int>& sinks) {
+    if (!built) build();
+    ws.sinks.clear();
+    for (int t : sinks) ws.sinks.push_back(inner(t));
+    bfs(ws);
+    touched.clear();
+    if (arc_partitioning) partition_arcs(ws);
+    Cap flow = 0;
+    vector<int> inner_sources;
+    ws.cur.assign(offset.begin(), offset.end() - 1);
+    for (int s : sources) {
+        inner_sources.push_back(inner(s));
+        flow += run(ws, inner_sources.back(), false);
+    }
+    bfs(ws);
+    ws.cut_sources = inner_sources;
+    ws.cut_level = n;
+    return flow;
+}
+
+/**
+ * @brief Computes a flow from s to t that respects the lower and upper bounds of add_bounded_edge, starting from zero
+ *        flow above the lower bounds, and returns its value, or -1 if there is none.
+ *        This is the textbook reduction to a maximum flow from a supersource SS, with an arc to each node of positive
+ *        demand, to a supersink TT, with an arc from each node of negative demand, plus an infinite (t, s) arc; a
+ *        feasible flow exists if and only if the flow saturates the arcs out of SS. The SS and TT arcs are not built:
+ *        every node of positive demand is a source of the ISAP loop with that much supply, and every node of negative
+ *        demand a sink taking at most its deficit. Only the (t, s) edge is added, as a real edge, and removed again
+ *        (it keeps its id, with capacity 0), which leaves the flow as an s-t flow of the value it carried. Later calls
+ *        with the same s and t reuse that edge, so repeated calls neither grow the graph nor rebuild it.
+ * @note The flow then continues in place, like any other: augment(s, t) turns it into a maximum feasible flow and
+ *       augment(t, s) pushes flow back for a minimum one, and neither can violate a lower bound.
+ * @note With a Res narrower than Cap, the (t, s) edge holds at most the largest Res, so the s-t value of the flow
+ *       must fit in Res, as the flow of any single edge must.
+ * @note Time Complexity: that of isap() on the graph plus one edge.
+ * @param s The source node.
+ * @param t The sink node.
+ * @return The s-t value of the flow, at least 0, or -1 if the bounds admit no flow.
+ */
+template <typename Cap, typename Res>
+Cap BasicIsap<Cap, Res>::feasible_flow(int s, int t) {
+    if (bounds_violated) return -1;
+    if (demand.empty()) demand.assign(n, 0);
+    // Infinite within the residual type, which for a narrow Res is its largest value.
+    Cap inf = to_res(CapTraits<Cap>::inf());
+    if (return_edge < 0 || edge_from[return_edge] != t || edge_to[return_edge] != s) {
+        return_edge = add_edge(t, s, inf);
+    }
+    int back = return_edge;
+    if (!built) build();
+    set_capacity(back, inf);
+    reset_flows();
+    ws.deficit.assign(n, 0);
+    ws.sinks.clear();
+    for (int v = 0; v < n; v++) {
+        if (demand[v] < 0) {
+            ws.deficit[inner(v)] = -demand[v];
+            ws.sinks.push_back(inner(v));
+        }
+    }
+    bfs(ws);
+    touched.clear();
+    if (arc_partitioning) partition_arcs(ws);
+    ws.cur.assign(offset.begin(), offset.end() - 1);
+    bool saturated = true;
+    for (int v = 0; v < n; v++) {
+        if (demand[v] > 0 && run(ws, inner(v), false, demand[v]) < demand[v]) {
+            saturated = false;
+            break;
+        }
+    }
+    ws.deficit.clear();
+    ws.labels_valid = false;
+    ws.cut_sources.assign(1, inner(s));
+    ws.cut_level = 0;
+    Cap value = get_edge(back).flow;
+    remove_edge(back);
+    return saturated ? value : -1;
+}
+
+/**
+ * @brief Augments from the current flow after capacity increases or new edges, and returns the additional flow.
+ *        The flow and distance labels of the previous solve are kept. Labels broken by the changes are repaired
+ *        locally, and a global relabel (BFS from the sink) only runs when there are no labels for t to start from,
+ *        e.g. on the first call, after reset_flows(), or when the sink changes.
+ * @note Time Complexity: proportional to the label repair plus the augmenting work for the additional flow,
+ *       instead of the full solve isap() performs.
+ * @param s The source node.
+ * @param t The sink node.
+ * @return The flow added on top of the current flow.
+ */
+template <typename Cap, typename Res>
+Cap BasicIsap<Cap, Res>::augment(int s, int t) {
+    if (!built) build();
+    s = inner(s);
+    t = inner(t);
+    if (!ws.labels_valid || ws.phase_labels || ws.label_sink != t) {
+        bfs(ws, t);
+        touched.clear();
+    } else {
+        ws.sinks.assign(1, t);
+        repair_labels();
+    }
+    if (arc_partitioning) partition_arcs(ws);
+    begin_progress();
+    return finish_progress(run(ws, s));
+}
+
+/**
+ * @brief Applies a batch of edge changes to the current flow and re-augments it, for networks where links go down,
+ *        capacities are throttled and new links arrive between solves.
+ *        Capacity changes and removals take effect in place and insertions are frozen into the CSR arrays once, as
+ *        with add_edge. Where a capacity drops below the flow of its edge, the flow is cut to the new capacity,
+ *        which leaves a surplus at the tail of the edge and a deficit at its head. Surpluses are then routed to
+ *        deficits along residual paths, which keeps the flow value; what is left of a surplus is returned to s and
+ *        what is left of a deficit is taken from t. Finally augment() continues from the repaired flow.
+ *        The label repair runs once for the whole batch, over every edge and arc whose residual grew.
+ * @note Time Complexity: O(E) per residual path of the rerouting, plus the label repair and augment().
+ * @param updates The changes, applied in order; Insert gives the next edge id, as add_edge would.
+ * @param s The source node.
+ * @param t The sink node.
+ * @return The change of the flow value from s to t, negative when the changes cut more flow than augment() finds.
+ */
+template <typename Cap, typename Res>
+Cap BasicIsap<Cap, Res>::apply_updates(const vector<BasicEdgeUpdate<Cap>>& updates, int s, int t) {
+    // The surplus (> 0) or deficit (< 0) of each node, by caller id, from flows cut to their new capacities.
+    vector<Cap> excess;
+    Cap delta = 0;
+    for (const auto& update : updates) {
+        if (update.kind == UpdateKind::Insert) {
+            add_edge(update.from, update.to, update.cap);
+            continue;
+        }
+        int id = update.id;
+        Cap cap = update.kind == UpdateKind::Remove ? 0 : (Cap)to_res(update.cap);
+        if (id < (int)edge_arc.size()) {
+            int a = edge_arc[id];
+            Cap flow = (Cap)edge_cap[id] - ws.res[a];
+            if (cap < flow) {
+                int u = edge_from[id], v = edge_to[id];
+                if (excess.empty()) excess.assign(n, 0);
+                excess[u] += flow - cap;
+                excess[v] -= flow - cap;
+                if (v == t) delta -= flow - cap;
+                if (u == t) delta += flow - cap;
+                ws.res[a] = 0;
+                ws.res[rev[a]] = cap;
+            } else {
+                ws.res[a] = cap - flow;
+            }
+            mark_stale(a);
+        }
+        edge_cap[id] = cap;
+        if (ws.labels_valid) touched.push_back(id);
+    }
+    if (!built) build();
+    if (!excess.empty()) {
+        int si = inner(s), ti = inner(t);
+        vector<Cap> inner_excess(n);
+        for (int v = 0; v < n; v++) inner_excess[inner(v)] = excess[v];
+        inner_excess[si] = inner_excess[ti] = 0;
+        vector<int> grown;
+        route_excess(inner_excess, grown);
+        inner_excess[si] = -CapTraits<Cap>::inf();
+        route_excess(inner_excess, grown);
+        // Only t supplies the last stage, so what it routes is the flow value given up.
+        for (Cap& e : inner_excess) e = min(e, (Cap)0);
+        inner_excess[si] = 0;
+        inner_excess[ti] = CapTraits<Cap>::inf();
+        delta -= route_excess(inner_excess, grown);
+        if (ws.labels_valid && !ws.phase_labels && ws.label_sink == ti) repair_labels(grown);
+    }
+    return delta + augment(s, t);
+}
+
+/**
+ * @brief Pushes flow from nodes with excess[v] > 0 to nodes with excess[v] < 0 along residual paths, one shortest
+ *        path (by a BFS from all of the former at once) at a time, until no path joins the two sides.
+ *        Every arc whose residual grows is appended to grown, for repair_labels.
+ * @return The total flow routed.
+ */
+template <typename Cap, typename Res>
+Cap BasicIsap<Cap, Res>::route_excess(vector<Cap>& excess, vector<int>& grown) {
+    Cap routed = 0;
+    // parent[v] is the arc the BFS reached v by, -1 for a node with excess and -2 for one not reached.
+    vector<int> parent(n);
+    vector<int> q;
+    while (true) {
+        fill(parent.begin(), parent.end(), -2);
+        q.clear();
+        for (int v = 0; v < n; v++) {
+            if (excess[v] > 0) {
+                parent[v] = -1;
+                q.push_back(v);
+            }
+        }
+        int sink = -1;
+        for (int i = 0; i < (int)q.size() && sink < 0; i++) {
+            int u = q[i];
+            for (int a = offset[u]; a < offset[u + 1] && sink < 0; a++) {
+                int v = head[a];
+                if (parent[v] == -2 && ws.res[a] > 0) {
+                    parent[v] = a;
+                    if (excess[v] < 0) sink = v;
+                    q.push_back(v);
+                }
+            }
+        }
+        if (sink < 0) return routed;
+        Cap f = -excess[sink];
+        int root = sink;
+        for (; parent[root] >= 0; root = head[rev[parent[root]]]) {
+            f = min(f, (Cap)ws.res[parent[root]]);
+        }
+        f = min(f, excess[root]);
+        for (int v = sink; parent[v] >= 0; v = head[rev[parent[v]]]) {
+            int a = parent[v];
+            ws.res[a] -= f;
+            ws.res[rev[a]] += f;
+            grown.push_back(rev[a]);
+            mark_stale(a);
+        }
+        excess[root] -= f;
+        excess[sink] += f;
+        routed += f;
+    }
+}
+
+/**
+ * @brief Arc-range kernels of the ISAP loop over the CSR arrays: the smallest label among heads of residual arcs
+ *        (for a relabel), and the first admissible arc (for an advance).
+ *        On x86-64 the ranges of high-degree nodes are scanned with AVX-512 or AVX2 gathers, picked once at
+ *        startup from what the CPU supports; short ranges, other CPUs and builds with -DISAP_NO_SIMD use the scalar
+ *        loops. AVX-512 is used for 32-bit residuals, AVX2 for 32- and 64-bit ones.
+ *        Masked-off lanes gather nothing, so the kernels read exactly the labels the scalar loops read.
+ */
+template <typename Res>
+static int scalar_min_level(const int* head, const Res* res, const int* level, int begin, int end, int none) {
+    int best = none;
+    for (int i = begin; i < end; i++) {
+        if (res[i] > 0) best = min(best, level[head[i]]);
+    }
+    return best;
+}
+
+template <typename Res>
+static int scalar_first_admissible(const int* head, const Res* res, const int* level, int begin, int end, int target) {
+    for (int i = begin; i < end; i++) {
+        if (res[i] > 0 && level[head[i]] == target) return i;
+    }
+    return end;
+}
+
+// The same scans during a phase of capacity scaling, where only residuals of at least delta count.
+template <typename Res>
+static int scaled_min_level(const int* head, const Res* res, const int* level, int begin, int end, int none, Res delta) {
+    int best = none;
+    for (int i = begin; i < end; i++) {
+        if (res[i] >= delta) best = min(best, level[head[i]]);
+    }
+    return best;
+}
+
+template <typename Res>
+static int scaled_first_admissible(const int* head, const Res* res, const int* level, int begin, int end, int target,
+                                   Res delta) {
+    for (int i = begin; i < end; i++) {
+        if (res[i] >= delta && level[head[i]] == target) return i;
+    }
+    return end;
+}
+
+template <typename Res>
+static int min_level(const int* head, const Res* res, const int* level, int begin, int end, int none) {
+    return scalar_min_level(head, res, level, begin, end, none);
+}
+
+template <typename Res>
+static int first_admissible(const int* head, const Res* res, const int* level, int begin, int end, int target) {
+    return scalar_first_admissible(head, res, level, begin, end, target);
+}
+
+#if defined(__x86_64__) && !defined(ISAP_NO_SIMD)
+
+// Ranges shorter than this are scanned by the scalar loops; a few gathers cost more than they save.
+const int SIMD_MIN_RANGE = 32;
+
+enum SimdLevel { SIMD_NONE, SIMD_AVX2, SIMD_AVX512 };
+
+// -DISAP_NO_AVX512 caps the dispatch at AVX2, e.g. to compare the kernels on one machine.
+static SimdLevel detect_simd() {
+    __builtin_cpu_init();
+#ifndef ISAP_NO_AVX512
+    if (__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+#endif
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    return SIMD_NONE;
+}
+
+static const SimdLevel simd_level = detect_simd();
+
+// The lanes of 8 32-bit residuals, or 4 64-bit ones, that are positive, as all-ones 32-bit masks.
+__attribute__((target("avx2"))) static inline __m256i positive_avx2(const int* res) {
+    return _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*)res), _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2"))) static inline __m256i positive_avx2(const uint32_t* res) {
+    __m256i zero = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)res), _mm256_setzero_si256());
+    return _mm256_xor_si256(zero, _mm256_set1_epi32(-1));
+}
+
+__attribute__((target("avx2"))) static inline __m128i narrow_mask_avx2(__m256i mask64) {
+    return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(mask64, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+}
+
+__attribute__((target("avx2"))) static inline __m128i positive_avx2(const long long* res) {
+    return narrow_mask_avx2(_mm256_cmpgt_epi64(_mm256_loadu_si256((const __m256i*)res), _mm256_setzero_si256()));
+}
+
+__attribute__((target("avx2"))) static inline __m128i positive_avx2(const double* res) {
+    return narrow_mask_avx2(_mm256_castpd_si256(_mm256_cmp_pd(_mm256_loadu_pd(res), _mm256_setzero_pd(), _CMP_GT_OQ)));
+}
+
+template <typename Res>
+__attribute__((target("avx2"))) static int min_level_avx2_32(const int* head, const Res* res, const int* level, int begin, int end, int none) {
+    __m256i best = _mm256_set1_epi32(none);
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256i idx = _mm256_loadu_si256((const __m256i*)(head + i));
+        best = _mm256_min_epi32(best, _mm256_mask_i32gather_epi32(best, level, idx, positive_avx2(res + i), 4));
+    }
+    __m128i m = _mm_min_epi32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, 0x4e));
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, 0xb1));
+    return scalar_min_level(head, res, level, i, end, _mm_cvtsi128_si32(m));
+}
+
+template <typename Res>
+__attribute__((target("avx2"))) static int min_level_avx2_64(const int* head, const Res* res, const int* level, int begin, int end, int none) {
+    __m128i best = _mm_set1_epi32(none);
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128i idx = _mm_loadu_si128((const __m128i*)(head + i));
+        best = _mm_min_epi32(best, _mm_mask_i32gather_epi32(best, level, idx, positive_avx2(res + i), 4));
+    }
+    best = _mm_min_epi32(best, _mm_shuffle_epi32(best, 0x4e));
+    best = _mm_min_epi32(best, _mm_shuffle_epi32(best, 0xb1));
+    return scalar_min_level(head, res, level, i, end, _mm_cvtsi128_si32(best));
+}
+
+template <typename Res>
+__attribute__((target("avx2"))) static int first_admissible_avx2_32(const int* head, const Res* res, const int* level, int begin, int end, int target) {
+    __m256i want = _mm256_set1_epi32(target);
+    __m256i none = _mm256_set1_epi32(-1);
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256i mask = positive_avx2(res + i);
+        __m256i idx = _mm256_loadu_si256((const __m256i*)(head + i));
+        __m256i hit = _mm256_cmpeq_epi32(_mm256_mask_i32gather_epi32(none, level, idx, mask, 4), want);
+        int bits = _mm256_movemask_ps(_mm256_castsi256_ps(hit));
+        if (bits) return i + __builtin_ctz(bits);
+    }
+    return scalar_first_admissible(head, res, level, i, end, target);
+}
+
+template <typename Res>
+__attribute__((target("avx2"))) static int first_admissible_avx2_64(const int* head, const Res* res, const int* level, int begin, int end, int target) {
+    __m128i want = _mm_set1_epi32(target);
+    __m128i none = _mm_set1_epi32(-1);
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128i idx = _mm_loadu_si128((const __m128i*)(head + i));
+        __m128i hit = _mm_cmpeq_epi32(_mm_mask_i32gather_epi32(none, level, idx, positive_avx2(res + i), 4), want);
+        int bits = _mm_movemask_ps(_mm_castsi128_ps(hit));
+        if (bits) return i + __builtin_ctz(bits);
+    }
+    return scalar_first_admissible(head, res, level, i, end, target);
+}
+
+// The lanes of 16 32-bit residuals that are positive.
+__attribute__((target("avx512f"))) static inline __mmask16 positive_avx512(const int* res) {
+    return _mm512_cmpgt_epi32_mask(_mm512_loadu_si512(res), _mm512_setzero_si512());
+}
+
+__attribute__((target("avx512f"))) static inline __mmask16 positive_avx512(const uint32_t* res) {
+    __m512i r = _mm512_loadu_si512(res);
+    return _mm512_test_epi32_mask(r, r);
+}
+
+template <typename Res>
+__attribute__((target("avx512f"))) static int min_level_avx512(const int* head, const Res* res, const int* level, int begin, int end, int none) {
+    __m512i best = _mm512_set1_epi32(none);
+    int i = begin;
+    for (; i + 16 <= end; i += 16) {
+        __m512i idx = _mm512_loadu_si512(head + i);
+        // The masked form with best as source avoids an undefined source operand, which GCC warns about.
+        best = _mm512_mask_min_epi32(best, 0xffff, best, _mm512_mask_i32gather_epi32(best, positive_avx512(res + i), idx, level, 4));
+    }
+    int lanes[16];
+    _mm512_storeu_si512(lanes, best);
+    return scalar_min_level(head, res, level, i, end, *min_element(lanes, lanes + 16));
+}
+
+template <typename Res>
+__attribute__((target("avx512f"))) static int first_admissible_avx512(const int* head, const Res* res, const int* level, int begin, int end, int target) {
+    __m512i want = _mm512_set1_epi32(target);
+    int i = begin;
+    for (; i + 16 <= end; i += 16) {
+        __mmask16 mask = positive_avx512(res + i);
+        __m512i idx = _mm512_loadu_si512(head + i);
+        __mmask16 hit = _mm512_mask_cmpeq_epi32_mask(mask, _mm512_mask_i32gather_epi32(want, mask, idx, level, 4), want);
+        if (hit) return i + __builtin_ctz(hit);
+    }
+    return scalar_first_admissible(head, res, level, i, end, target);
+}
+
+// Dispatch for 32-bit residuals: AVX-512, then AVX2, then scalar.
+#define ISAP_SIMD_32(Res)                                                                                          \
+    template <>                                                                                                    \
+    int min_level(const int* head, const Res* res, const int* level, int begin, int end, int none) {               \
+        if (end - begin < SIMD_MIN_RANGE) return scalar_min_level(head, res, level, begin, end, none);             \
+        if (simd_level == SIMD_AVX512) return min_level_avx512(head, res, level, begin, end, none);              \
+        if (simd_level == SIMD_AVX2) return min_level_avx2_32(head, res, level, begin, end, none);               \
+        return scalar_min_level(head, res, level, begin, end, none);                                              \
+    }                                                                                                              \
+    template <>                                                                                                    \
+    int first_admissible(const int* head, const Res* res, const int* level, int begin, int end, int target) {      \
+        if (end - begin < SIMD_MIN_RANGE) return scalar_first_admissible(head, res, level, begin, end, target);    \
+        if (simd_level == SIMD_AVX512) return first_admissible_avx512(head, res, level, begin, end, target);     \
+        if (simd_level == SIMD_AVX2) return first_admissible_avx2_32(head, res, level, begin, end, target);      \
+        return scalar_first_admissible(head, res, level, begin, end, target);                                     \
+    }
+
+// Dispatch for 64-bit residuals: AVX2, then scalar.
+#define ISAP_SIMD_64(Res)                                                                                          \
+    template <>                                                                                                    \
+    int min_level(const int* head, const Res* res, const int* level, int begin, int end, int none) {               \
+        if (end - begin < SIMD_MIN_RANGE || simd_level == SIMD_NONE) {                                             \
+            return scalar_min_level(head, res, level, begin, end, none);                                           \
+        }                                                                                                          \
+        return min_level_avx2_64(head, res, level, begin, end, none);                                            \
+    }                                                                                                              \
+    template <>                                                                                                    \
+    int first_admissible(const int* head, const Res* res, const int* level, int begin, int end, int target) {      \
+        if (end - begin < SIMD_MIN_RANGE || simd_level == SIMD_NONE) {                                             \
+            return scalar_first_admissible(head, res, level, begin, end, target);                                  \
+        }                                                                                                          \
+        return first_admissible_avx2_64(head, res, level, begin, end, target);                                   \
+    }
+
+ISAP_SIMD_32(int)
+ISAP_SIMD_32(uint32_t)
+ISAP_SIMD_64(long long)
+ISAP_SIMD_64(double)
+
+#endif
+
+/**
+ * @brief The ISAP main loop on workspace w from s, starting from its current flow and valid distance labels to the
+ *        sinks w.sinks, i.e. the nodes at level 0. On return the labels and gap counts are still valid, so augment()
+ *        can continue from them. With reset_arcs false, the current arcs are kept from the previous run on the same
+ *        labels, which stay valid for any source.
+ *        Only w is written to, so runs on different workspaces can proceed in parallel; the exception is a partitioned
+ *        w (see set_arc_partitioning), whose augmentations also reorder the shared arc arrays.
+ *        It stops once supply has been routed from s, and a non-empty w.deficit bounds what each sink takes.
+ */
+template <typename Cap, typename Res>
+Cap BasicIsap<Cap, Res>::run(Workspace& w, int s, bool reset_arcs, Cap supply) {
+    w.cut_sources.assign(1, s);
+    w.cut_level = 0;
     // If there is no path from source to sink, return 0
-    if (level[s] == -1) {
+    if (w.level[s] >= n || w.level[s] == 0) {
         return 0;
     }
     /**
      * flow: A variable to keep track of the current maximum flow.
      * u: The current vertex in the graph which starts from source s.
-     * cur: The current edge in the adjacency list of each node being considered for augmenting path.
+     * cur: The absolute index of the current arc of each node being considered for augmenting path.
+     *      cur and path live in the workspace, so repeated solves reuse their storage.
      * path: Stores the nodes in the current augmenting path from source to the current node u.
      *      It's used to track the path's edges and their capacities for flow augmentation.
+     * relabels, scans: Local relabels and the arcs they scanned since the last global relabel.
      */
-    int flow = 0, u = s;
-    vector<int> cur(n, 0);
-    vector<int> path;
-    while (level[s] < n) {
-        if (u == t) {
-            int f = INF;
-            for (int i = 0; i < path.size(); i++) {
-                f = min(f, adj[path[i]][cur[path[i]]].cap - adj[path[i]][cur[path[i]]].flow);
-            }
-            for (int i = 0; i < path.size(); i++) {
-                int u = path[i];
-                int rev = adj[u][cur[u]].rev;
-                adj[u][cur[u]].flow += f;
-                adj[adj[u][cur[u]].to][rev].flow -= f;
+    Cap flow = 0;
+    int u = s;
+    if (reset_arcs) w.cur.assign(offset.begin(), offset.end() - 1);
+    w.path.clear();
+    w.bottleneck.clear();
+    long long relabels = 0, scans = 0;
+    long long relabel_limit = relabel_policy.relabels_per_node > 0 ? (long long)(relabel_policy.relabels_per_node * n) : LLONG_MAX;
+    long long scan_limit = relabel_policy.arc_scans_per_arc > 0 ? (long long)(relabel_policy.arc_scans_per_arc * head.size()) : LLONG_MAX;
+    bool partitioned = !w.live_end.empty();
+    auto live_end = [&](int v) { return partitioned ? w.live_end[v] : offset[v + 1]; };
+    // Pushes f along arc a of node x and returns whether it saturated a. A partitioned w keeps a revived reverse arc
+    // in the live range of its tail and moves a saturated arc out of the live range of x, so the position of a then
+    // holds another live arc (or the end of the range), which is where the scan of x continues.
+    auto push = [&](int x, int a, Res f) {
+        int b = rev[a], y = head[a];
+        w.res[a] -= f;
+        w.res[b] += f;
+        bool saturated = w.res[a] == 0;
+        if (partitioned) {
+            if (b >= w.live_end[y]) swap_arcs(w, b, w.live_end[y]++);
+            if (saturated) swap_arcs(w, a, --w.live_end[x]);
+        }
+        // During a scaling phase an arc left below delta no longer counts either.
+        return saturated || w.res[a] < w.delta;
+    };
+    bool scaled = w.delta > 0;
+    // Progress: the flow of earlier runs of the same solve, and the steps since the last check.
+    BasicSolveProgress<Cap>* watch = w.watch;
+    Cap base = watch ? watch->flow.load(memory_order_relaxed) : 0;
+    int steps = 0;
+    auto must_stop = [&]() {
+        watch->flow.store(base + flow, memory_order_relaxed);
+        watch->source_level.store(w.level[s], memory_order_relaxed);
+        watch->source_level_nodes.store(w.gap[w.level[s]], memory_order_relaxed);
+        return watch->cancel.load(memory_order_relaxed) ||
+               (watch->deadline != chrono::steady_clock::time_point::max() && chrono::steady_clock::now() >= watch->deadline);
+    };
+    // A scaling phase ends with s cut off in a sparser graph, which local relabels only notice after raising labels
+    // towards n; a global relabel every n / 4 relabels notices it early.
+    if (scaled) relabel_limit = min(relabel_limit, max(1LL, (long long)n / 4));
+    auto lowest_level = [&](int x, int e) {
+        return scaled ? scaled_min_level(head.data(), w.res.data(), w.level.data(), offset[x], e, n, w.delta)
+                      : ::min_level(head.data(), w.res.data(), w.level.data(), offset[x], e, n);
+    };
+    // Caps the flow f into sink x by what s and x have left. A sink whose deficit this fills is no longer one: it is
+    // relabeled like any node, which keeps the labels valid, and its arc into it on the path is then inadmissible.
+    bool bounded = !w.deficit.empty();
+    auto limit = [&](int x, Res f) { return (Res)min({(Cap)f, supply - flow, bounded ? w.deficit[x] : (Cap)f}); };
+    auto settle = [&](int x, Res f) {
+        if (!bounded || (w.deficit[x] -= f) > 0) return false;
+        w.gap[0]--;
+        w.gap[w.level[x] = lowest_level(x, live_end(x)) + 1]++;
+        return true;
+    };
+    while (w.level[s] < n) {
+        if (watch && ++steps == 4096) {
+            steps = 0;
+            if (must_stop()) {
+                Cap bound = cut_bound(w, s);
+                Cap total = base + flow;
+                watch->upper_bound.store(bound >= CapTraits<Cap>::inf() - total ? CapTraits<Cap>::inf() : total + bound,
+                                         memory_order_relaxed);
+                watch->stopped.store(true, memory_order_relaxed);
+                break;
+            }
+        }
+        if (w.level[u] == 0 && augment_mode == AugmentMode::Restart) {
+            Res f = numeric_limits<Res>::max();
+            for (int i = 0; i < (int)w.path.size(); i++) {
+                f = min(f, w.res[w.cur[w.path[i]]]);
+            }
+            f = limit(u, f);
+            for (int i = 0; i < (int)w.path.size(); i++) {
+                push(w.path[i], w.cur[w.path[i]], f);
             }
             flow += f;
+            settle(u, f);
+            ISAP_COUNT(w.counters.augmentations++);
+            ISAP_COUNT(w.counters.path_length += w.path.size());
+            if (flow >= supply) break;
             u = s;
-            path.clear();
+            w.path.clear();
+        } else if (w.level[u] == 0) {
+            // The bottleneck is already known; push it and keep the prefix of the path up to the first saturated arc.
+            Res f = limit(u, w.bottleneck.back());
+            int k = w.path.size();
+            for (int i = 0; i < (int)w.path.size(); i++) {
+                if (push(w.path[i], w.cur[w.path[i]], f) && k == (int)w.path.size()) k = i;
+            }
+            flow += f;
+            // With no arc saturated, the sink was filled; retreat to the node before it.
+            if (settle(u, f) && k == (int)w.path.size()) k--;
+            ISAP_COUNT(w.counters.augmentations++);
+            ISAP_COUNT(w.counters.path_length += w.path.size());
+            if (flow >= supply) break;
+            for (int i = 0; i < k; i++) {
+                w.bottleneck[i] -= f;
+            }
+            u = w.path[k];
+            w.path.resize(k);
+            w.bottleneck.resize(k);
         }
         bool advanced = false;
-        for (; cur[u] < adj[u].size(); cur[u]++) {
-            Edge &e = adj[u][cur[u]];
-            if (e.cap > e.flow && level[u] == level[e.to] + 1) {
-                path.push_back(u);
-                u = e.to;
-                advanced = true;
-                break;
+        int end = live_end(u);
+        if (scaled) {
+            w.cur[u] = scaled_first_admissible(head.data(), w.res.data(), w.level.data(), w.cur[u], end, w.level[u] - 1,
+                                               w.delta);
+        } else {
+            w.cur[u] = first_admissible(head.data(), w.res.data(), w.level.data(), w.cur[u], end, w.level[u] - 1);
+        }
+        if (w.cur[u] < end) {
+            int a = w.cur[u];
+            if (augment_mode == AugmentMode::Retreat) {
+                w.bottleneck.push_back(w.path.empty() ? w.res[a] : min(w.bottleneck.back(), w.res[a]));
             }
+            w.path.push_back(u);
+            u = head[a];
+            advanced = true;
+            ISAP_COUNT(w.counters.advances++);
         }
         if (!advanced) {
-            int min_level = n;
-            for (auto &e : adj[u]) {
-                if (e.cap > e.flow) {
-                    min_level = min(min_level, level[e.to]);
-                }
+            int min_level = lowest_level(u, end);
+            scans += end - offset[u];
+            ISAP_COUNT(w.counters.relabel_arc_scans += end - offset[u]);
+            // The dead arcs were skipped twice: by the advance that just failed and by the minimum.
+            ISAP_COUNT(w.counters.dead_arc_skips += 2 * (offset[u + 1] - end));
+            // Gap heuristic: if u is the last node at its level, no node above it can reach t.
+            // u keeps its label, so the labels and gap counts stay consistent for a later augment().
+            if (w.gap[w.level[u]] == 1) {
+                ISAP_COUNT(w.counters.gap_cutoffs++);
+                w.cut_level = w.level[u];
+                break;
+            }
+            w.gap[w.level[u]]--;
+            w.gap[w.level[u] = min_level + 1]++;
+            ISAP_COUNT(w.counters.relabels++);
+            w.cur[u] = offset[u];
+            if (!w.path.empty()) {
+                u = w.path.back();
+                w.path.pop_back();
+                if (augment_mode == AugmentMode::Retreat) w.bottleneck.pop_back();
             }
-            if (--gap[level[u]] == 0) break;
-            gap[level[u] = min_level + 1]++;
-            cur[u] = 0;
-            if (!path.empty()) {
-                u = path.back();
-                path.pop_back();
+            if (++relabels >= relabel_limit || scans >= scan_limit) {
+                // Global relabel: the labels changed everywhere, so the current path is abandoned.
+                if (bounded) {
+                    w.sinks.erase(remove_if(w.sinks.begin(), w.sinks.end(), [&](int v) { return w.deficit[v] <= 0; }),
+                                  w.sinks.end());
+                }
+                bfs(w);
+                w.global_relabels++;
+                relabels = scans = 0;
+                w.cur.assign(offset.begin(), offset.end() - 1);
+                w.path.clear();
+                w.bottleneck.clear();
+                u = s;
             }
         }
     }
     return flow;
 }
+
+/**
+ * @brief Adds the counters of from to into, for merging the statistics of worker workspaces.
+ */
+static void accumulate(IsapStats& into, const IsapStats& from) {
+    into.augmentations += from.augmentations;
+    into.path_length += from.path_length;
+    into.advances += from.advances;
+    into.relabels += from.relabels;
+    into.relabel_arc_scans += from.relabel_arc_scans;
+    into.dead_arc_skips += from.dead_arc_skips;
+    into.gap_cutoffs += from.gap_cutoffs;
+    into.bfs_runs += from.bfs_runs;
+    into.bfs_ns += from.bfs_ns;
+}
+
+/**
+ * @brief Computes the maximum flow of every (s, t) pair independently, from zero flow, on a pool of threads.
+ *        The CSR arrays and capacities are shared read-only. Each worker owns a Workspace (residuals, labels, gap
+ *        counts and current arcs) that it resets for every pair, so the graph is never copied per pair and the flow
+ *        held by this solver is left untouched.
+ *        Pairs are dealt round-robin into one deque per worker. A worker takes from the front of its own deque
+ *        and, once that is empty, steals from the back of the others, so uneven pairs still keep every core busy.
+ * @note Time Complexity: the sum of the single solves, divided across the threads; each worker adds O(V + E) memory.
+ * @param pairs The (source, sink) pairs.
+ * @param threads The number of worker threads, including the calling one.
+ * @param source_sides If not null, receives the source side of a minimum cut of each pair, as min_cut_source_side().
+ * @return The maximum flow of each pair, in the order of pairs.
+ */
+template <typename Cap, typename Res>
+vector<Cap> BasicIsap<Cap, Res>::max_flow_batch(const vector<pair<int, int>>& pairs, int threads,
+                                                vector<vector<bool>>* source_sides) {
+    if (!built) build();
+    threads = max(1, min(threads, (int)pairs.size()));
+    vector<Res> capacity(head.size(), 0);
+    for (int id = 0; id < (int)edge_arc.size(); id++) {
+        capacity[edge_arc[id]] = edge_cap[id];
+    }
+    vector<Cap> flows(pairs.size(), 0);
+    if (source_sides) source_sides->assign(pairs.size(), {});
+    vector<deque<int>> queues(threads);
+    vector<mutex> locks(threads);
+    for (int i = 0; i < (int)pairs.size(); i++) {
+        queues[i % threads].push_back(i);
+    }
+    vector<Workspace> spaces(threads);
+    auto worker = [&](int id) {
+        Workspace& w = spaces[id];
+        w.level.resize(n);
+        w.gap.resize(n + 2);
+        while (true) {
+            int job = -1;
+            for (int k = 0; k < threads && job < 0; k++) {
+                int victim = (id + k) % threads;
+                lock_guard<mutex> guard(locks[victim]);
+                if (queues[victim].empty()) continue;
+                if (k == 0) {
+                    job = queues[victim].front();
+                    queues[victim].pop_front();
+                } else {
+                    job = queues[victim].back();
+                    queues[victim].pop_back();
+                }
+            }
+            if (job < 0) return;
+            w.res = capacity;
+            bfs(w, inner(pairs[job].second));
+            flows[job] = run(w, inner(pairs[job].first));
+            if (source_sides) (*source_sides)[job] = cut_side(w, true);
+        }
+    };
+    vector<thread> pool;
+    for (int id = 1; id < threads; id++) {
+        pool.emplace_back(worker, id);
+    }
+    worker(0);
+    for (auto& th : pool) {
+        th.join();
+    }
+    for (const auto& w : spaces) {
+        accumulate(ws.counters, w.counters);
+        ws.global_relabels += w.global_relabels;
+    }
+    return flows;
+}
+
+template class BasicIsap<int>;
+template class BasicIsap<long long>;
+template class BasicIsap<double>;
+template class BasicIsap<long long, uint32_t>;
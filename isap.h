@@ -5,31 +5,335 @@
 #include <vector>
 #include <queue>
 #include <algorithm>
+#include <string>
+#include <limits>
+#include <cstdint>
+#include <utility>
+#include <atomic>
+#include <chrono>
+#include <type_traits>
 
 using namespace std;
 
 const int INF = 1e9;
 
-struct Edge {
+/**
+ * @brief A capacity large enough to act as infinite for Cap: no finite cut reaches it, and adding two of them does not overflow.
+ */
+template <typename Cap>
+struct CapTraits {
+    static Cap inf() { return numeric_limits<Cap>::max() / 2; }
+};
+
+template <>
+struct CapTraits<int> {
+    static int inf() { return INF; }
+};
+
+/**
+ * @brief The type of edge costs and total costs for capacities of type Cap, see BasicIsap::min_cost_flow:
+ *        long long for integral capacities, so that a cost times a flow does not overflow with Cap = int, and double
+ *        otherwise.
+ */
+template <typename Cap>
+using CostType = typename conditional<numeric_limits<Cap>::is_integer, long long, double>::type;
+
+/**
+ * @brief A view of an added edge, as returned by BasicIsap::get_edge.
+ *        rev is the index of the reverse arc in the solver's arc arrays; cost is 0 for an edge added without one.
+ *        For an edge from add_bounded_edge, cap is its upper bound and flow includes its lower bound.
+ */
+template <typename Cap>
+struct BasicEdge {
     int to;
-    int cap;
-    int flow;
+    Cap cap;
+    Cap flow;
     int rev;
+    CostType<Cap> cost;
+};
+
+/**
+ * @brief The kind of a change in BasicIsap::apply_updates.
+ */
+enum class UpdateKind {
+    // Set the capacity of edge id to cap.
+    SetCapacity,
+    // Add an edge from from to to with capacity cap. It gets the next edge id, as from add_edge.
+    Insert,
+    // Remove edge id: its capacity becomes 0, like remove_edge, but its flow is rerouted.
+    Remove
 };
 
-class Isap {
+/**
+ * @brief One change in a batch for BasicIsap::apply_updates. Fields a kind does not use are ignored.
+ */
+template <typename Cap>
+struct BasicEdgeUpdate {
+    UpdateKind kind;
+    int id;
+    int from;
+    int to;
+    Cap cap;
+};
+
+/**
+ * @brief When the ISAP loop recomputes all labels with bfs() over the current residual graph (a global relabel).
+ *        Local relabels only ever raise a label by looking at its neighbours, so on large sparse graphs the labels
+ *        drift below the true distances; a periodic global relabel brings them back. A value of 0 disables a trigger.
+ */
+struct GlobalRelabelPolicy {
+    // Relabel globally after every relabels_per_node * n local relabels.
+    double relabels_per_node = 0;
+    // Relabel globally after local relabels have scanned arc_scans_per_arc * m arcs in total.
+    double arc_scans_per_arc = 0;
+};
+
+/**
+ * @brief How the ISAP loop continues after augmenting along a path.
+ */
+enum class AugmentMode {
+    // Recompute the bottleneck over the whole path, then search again from the source.
+    Restart,
+    // Track the bottleneck while advancing, and retreat only to the tail of the first saturated arc.
+    Retreat
+};
+
+/**
+ * @brief The algorithm BasicIsap::max_flow runs. All work on the same CSR arrays and leave the flow in the solver.
+ */
+enum class Engine {
+    // The sequential ISAP loop of isap().
+    Isap,
+    // Synchronous parallel push-relabel, see push_relabel(); for large graphs and several threads.
+    ParallelPushRelabel,
+    // Phase-based augmentation on one bit per arc, see unit_capacity_flow(); runs Isap unless every residual is 0 or 1.
+    UnitCapacity,
+    // UnitCapacity when every residual is 0 or 1, Isap otherwise.
+    Auto,
+    // isap() on the residual graph compacted by pruned_isap().
+    PrunedIsap,
+    // Sequential highest-label push-relabel, see highest_label_push_relabel(); for dense graphs.
+    HighestLabel
+};
+
+/**
+ * @brief How BasicIsap numbers the nodes internally, see BasicIsap::set_node_order. Every order is computed on the
+ *        undirected graph of the added edges; node ids in the interface stay the caller's.
+ */
+enum class NodeOrder {
+    // The caller's ids.
+    Given,
+    // Breadth-first order from the root node, e.g. the sink, so that each BFS level of bfs() is one contiguous range.
+    Bfs,
+    // Reverse Cuthill-McKee: breadth-first from a low-degree node, neighbours by increasing degree, then reversed.
+    ReverseCuthillMcKee,
+    // By decreasing degree, so that the labels of the high-degree nodes most arcs point to share cache lines.
+    Degree
+};
+
+/**
+ * @brief A channel between a running solve and other threads, see BasicIsap::set_progress.
+ *        The solve publishes its state every few thousand steps of the ISAP loop with relaxed atomic stores, so
+ *        readers never block it, and reads cancel and deadline at the same points.
+ */
+template <typename Cap>
+struct BasicSolveProgress {
+    // Published by the solve: n, the flow it has routed so far, the label of s, which ends the solve when it reaches
+    // nodes, and the number of nodes at that label, the gap the heuristic ends the solve at once s is relabeled away.
+    atomic<int> nodes{0};
+    atomic<Cap> flow{0};
+    atomic<int> source_level{0};
+    atomic<int> source_level_nodes{0};
+    // Once done: an upper bound on the flow the solve could have routed, equal to flow unless it stopped early, on
+    // cancel or the deadline.
+    atomic<Cap> upper_bound{0};
+    atomic<bool> stopped{false};
+    atomic<bool> done{false};
+    // Set by any thread to stop the solve at its next check; not cleared by the solve.
+    atomic<bool> cancel{false};
+    // Set before the solve: it stops at its first check past the deadline.
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+};
+
+/**
+ * @brief Work counters of the ISAP loop, accumulated over all solves since the last reset_stats().
+ *        The counters are only maintained when isap.cc is compiled with -DISAP_STATS; otherwise the increments are
+ *        compiled out, the counters stay 0 and BasicIsap::stats_enabled() returns false.
+ */
+struct IsapStats {
+    // augmentations: Augmenting paths pushed. path_length: Their total number of arcs.
+    long long augmentations = 0;
+    long long path_length = 0;
+    // advances: Steps forward along an admissible arc.
+    long long advances = 0;
+    // relabels: Local relabels. relabel_arc_scans: Arcs scanned by them.
+    long long relabels = 0;
+    long long relabel_arc_scans = 0;
+    // dead_arc_skips: Arc scans saved by set_arc_partitioning(): arcs behind the live range of a node that the failed
+    // advance and the relabel before it would otherwise have read.
+    long long dead_arc_skips = 0;
+    // gap_cutoffs: Solves ended by the gap heuristic.
+    long long gap_cutoffs = 0;
+    // bfs_runs, bfs_ns: Global labelings by bfs(), including the initial one of isap(), and their wall time.
+    long long bfs_runs = 0;
+    long long bfs_ns = 0;
+
+    string to_json() const;
+};
+
+/**
+ * @brief ISAP max-flow solver templated on the capacity type Cap and the residual storage type Res.
+ *        BasicIsap is explicitly instantiated for <int>, <long long>, <double> and <long long, uint32_t> in isap.cc.
+ */
+template <typename Cap, typename Res = Cap>
+class BasicIsap {
 public:
-    Isap(int n);
-    void add_edge(int from, int to, int cap);
-    int isap(int s, int t);
+    BasicIsap(int n, int expected_edges = 0);
+    void reserve(int edges);
+    void clear(int n);
+    int add_edge(int from, int to, Cap cap);
+    int add_edge(int from, int to, Cap cap, CostType<Cap> cost);
+    int add_bounded_edge(int from, int to, Cap lower, Cap upper);
+    Cap isap(int s, int t);
+    Cap isap(const vector<int>& sources, const vector<int>& sinks);
+    Cap augment(int s, int t);
+    Cap feasible_flow(int s, int t);
+    int edge_count() const;
+    BasicEdge<Cap> get_edge(int id) const;
+    void reset_flows();
+    void set_capacity(int id, Cap cap);
+    void remove_edge(int id);
+    Cap apply_updates(const vector<BasicEdgeUpdate<Cap>>& updates, int s, int t);
+    void set_global_relabel_policy(const GlobalRelabelPolicy& policy);
+    long long global_relabel_count() const;
+    void set_augment_mode(AugmentMode mode);
+    void set_node_order(NodeOrder order, int root = 0);
+    void set_arc_partitioning(bool enabled);
+    void set_capacity_scaling(bool enabled);
+    void set_progress(BasicSolveProgress<Cap>* progress);
+    vector<bool> min_cut_source_side() const;
+    vector<int> min_cut_edges() const;
+    const IsapStats& stats() const;
+    void reset_stats();
+    static bool stats_enabled();
+    Cap push_relabel(int s, int t, int threads);
+    Cap highest_label_push_relabel(int s, int t);
+    bool has_unit_capacities() const;
+    Cap unit_capacity_flow(int s, int t);
+    Cap pruned_isap(int s, int t);
+    Cap max_flow(int s, int t, Engine engine = Engine::Isap, int threads = 1);
+    pair<Cap, CostType<Cap>> min_cost_flow(int s, int t, Cap limit = CapTraits<Cap>::inf());
+    bool save_snapshot(const string& path);
+    bool load_snapshot(const string& path);
+    vector<Cap> max_flow_batch(const vector<pair<int, int>>& pairs, int threads,
+                               vector<vector<bool>>* source_sides = nullptr);
 
 private:
+    /**
+     * @brief Everything a solve writes to. The primary workspace ws holds the flow the other methods see;
+     *        max_flow_batch gives each worker thread its own, over the same read-only CSR arrays.
+     */
+    struct Workspace {
+        // res[a] is the residual capacity (cap - flow) of arc a.
+        vector<Res> res;
+        vector<int> level;
+        vector<int> gap;
+        // Whether level/gap are valid distance labels to the nodes of sinks for res; label_sink is the sink if there is
+        // only one, -1 otherwise. The sinks are exactly the nodes at level 0.
+        bool labels_valid = false;
+        int label_sink = -1;
+        // Set when a solve stopped during a phase of capacity scaling: the labels then only count the arcs of that
+        // phase. They still give the cut the solve stopped at, but no start for augment().
+        bool phase_labels = false;
+        vector<int> sinks;
+        // The sources of the last solve, and the empty level its labels stopped at (0 if not recorded; see min_cut_source_side).
+        vector<int> cut_sources;
+        int cut_level = 0;
+        // Scratch buffers of the ISAP loop, kept across calls so a re-solve does not allocate.
+        vector<int> cur;
+        vector<int> path;
+        // bottleneck[i] is the smallest residual on the arcs of path[0..i], in AugmentMode::Retreat.
+        vector<Res> bottleneck;
+        // With arc partitioning, the arcs of u with a residual are offset[u] .. live_end[u] - 1 and the saturated ones
+        // follow; arc_edge[a] is the edge whose forward arc a is, or -1. live_end is empty while no partition is kept,
+        // and stale lists the nodes whose arcs changed residual outside the ISAP loop since the last partition.
+        vector<int> live_end;
+        vector<int> arc_edge;
+        vector<int> stale;
+        // Set by feasible_flow: a sink v takes at most deficit[v] more flow, and leaves sinks when that reaches 0.
+        // Empty otherwise, when every sink takes any amount.
+        vector<Cap> deficit;
+        // During a phase of capacity scaling, only arcs with a residual of at least delta count; 0 otherwise.
+        Res delta = 0;
+        // The progress channel of the solve running on this workspace, or null.
+        BasicSolveProgress<Cap>* watch = nullptr;
+        long long global_relabels = 0;
+        IsapStats counters;
+    };
+
     int n;
-    vector<vector<Edge>> adj;
-    vector<int> level;
-    vector<int> gap;
+    bool built;
+    // Edges whose residual capacity may have grown since ws's labels were computed, see repair_labels.
+    vector<int> touched;
+    // Edges in insertion order, frozen into the CSR arrays on the next solve.
+    vector<int> edge_from;
+    vector<int> edge_to;
+    vector<Res> edge_cap;
+    // The cost of each edge added with one; edges past its end cost 0. Empty when no edge has a cost.
+    vector<CostType<Cap>> edge_cost;
+    // The lower bound of each edge added with add_bounded_edge, whose edge_cap is upper - lower; edges past its end
+    // have none. demand[v] is the sum of the lower bounds into caller node v minus those out of it. Both are empty
+    // while no edge has a lower bound; bounds_violated records an edge with lower > upper.
+    vector<Cap> edge_lower;
+    vector<Cap> demand;
+    bool bounds_violated;
+    // The (t, s) edge feasible_flow() added, kept at capacity 0 between calls and reused by the next call with the
+    // same s and t; -1 if there is none.
+    int return_edge;
+    // The arcs of node u are offset[u] .. offset[u + 1] - 1, stored as separate arrays:
+    // head[a] is the node arc a points to and rev[a] the index of its reverse arc; residuals live in a Workspace.
+    vector<int> offset;
+    vector<int> head;
+    vector<int> rev;
+    // The forward arc of each added edge.
+    vector<int> edge_arc;
+    // node_pos[v] is the internal number of the caller's node v and node_id its inverse; both empty for NodeOrder::Given.
+    // Every node-indexed array, head and the labels included, uses internal numbers.
+    NodeOrder node_order;
+    int order_root;
+    vector<int> node_pos;
+    vector<int> node_id;
+    Workspace ws;
+    AugmentMode augment_mode;
+    GlobalRelabelPolicy relabel_policy;
+    bool arc_partitioning;
+    bool capacity_scaling;
+    BasicSolveProgress<Cap>* progress;
 
-    void bfs(int t);
+    static Res to_res(Cap cap);
+    void build();
+    void compute_node_order();
+    int inner(int v) const;
+    void bfs(Workspace& w, int t) const;
+    void bfs(Workspace& w) const;
+    void repair_labels(const vector<int>& grown = {});
+    Cap route_excess(vector<Cap>& excess, vector<int>& grown);
+    void partition_arcs(Workspace& w);
+    void partition_node(Workspace& w, int u);
+    void mark_stale(int a);
+    void swap_arcs(Workspace& w, int p, int q);
+    Cap run(Workspace& w, int s, bool reset_arcs = true, Cap supply = numeric_limits<Cap>::max());
+    vector<bool> cut_side(const Workspace& w, bool unchanged) const;
+    void begin_progress();
+    Cap finish_progress(Cap flow);
+    Cap cut_bound(Workspace& w, int s) const;
+    void push_relabel_labels(vector<int>& label, int target, int blocked) const;
+    void push_relabel_phase(atomic<Cap>* excess, vector<int>& label, int target, int blocked, int threads);
 };
 
+typedef BasicEdge<int> Edge;
+typedef BasicEdgeUpdate<int> EdgeUpdate;
+typedef BasicSolveProgress<int> SolveProgress;
+typedef BasicIsap<int> Isap;
+
 #endif // ISAP_H
\ No newline at end of file
@@ -0,0 +1,541 @@
+#include "isap.h"
+#include "isap_feasible_flow.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * Performance suite for Isap and has_feasible_flow. Link with isap.cc, isap_push_relabel.cc,
+ * isap_unit_capacity.cc, isap_prune.cc, isap_max_flow.cc, isap_min_cost_flow.cc and isap_feasible_flow.cc.
+ *
+ * Usage: isap_benchmark [--filter=<substring>] [--repetitions=<n>] [--format=json]
+ *
+ * Build isap.cc with -DISAP_STATS to report augmentation and relabel counts; without it they are printed as -1.
+ *
+ * Every benchmark runs in a forked child, so peak_rss_kb is the peak memory of that benchmark alone.
+ * Solves are timed after the graph is built; repetitions after the first reuse the graph through reset_flows().
+ * With --format=json the results are printed in the layout of Google Benchmark's JSON reporter, so existing
+ * tooling for tracking regressions across releases can read them.
+ */
+
+struct BenchmarkResult {
+    int nodes = 0;
+    long long edges = 0;
+    double ns = 0;
+    // The maximum flow, or 1 / 0 for feasible / infeasible lower-bound networks.
+    long long flow = 0;
+    // -1 where the counters are compiled out or the solver is not reachable from the benchmark, as inside has_feasible_flow.
+    long long augmentations = -1;
+    long long relabels = -1;
+    long peak_rss_kb = 0;
+};
+
+struct Benchmark {
+    string name;
+    // Builds the instance and runs it repetitions times, filling everything but peak_rss_kb.
+    function<void(int repetitions, BenchmarkResult&)> run;
+};
+
+/**
+ * @brief Times repetitions solves of an already built graph and records its counters.
+ */
+static void time_solve(Isap& graph, int nodes, int s, int t, int repetitions, BenchmarkResult& result,
+                       Engine engine = Engine::Isap, int threads = 1) {
+    result.nodes = nodes;
+    result.edges = graph.edge_count();
+    double total = 0;
+    for (int r = 0; r < repetitions; r++) {
+        graph.reset_flows();
+        graph.reset_stats();
+        auto start = chrono::steady_clock::now();
+        result.flow = graph.max_flow(s, t, engine, threads);
+        total += chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    }
+    result.ns = total / repetitions;
+    if (Isap::stats_enabled()) {
+        result.augmentations = graph.stats().augmentations;
+        result.relabels = graph.stats().relabels;
+    }
+}
+
+/**
+ * @brief The name suffix of a benchmark solved by engine instead of isap().
+ */
+static string engine_suffix(Engine engine, int threads = 1) {
+    switch (engine) {
+    case Engine::ParallelPushRelabel:
+        return "/push_relabel/" + to_string(threads);
+    case Engine::UnitCapacity:
+        return "/unit";
+    case Engine::PrunedIsap:
+        return "/pruned";
+    case Engine::HighestLabel:
+        return "/highest_label";
+    default:
+        return "";
+    }
+}
+
+/**
+ * @brief The name suffix of a benchmark solved under an internal node order other than NodeOrder::Given.
+ */
+static string order_suffix(NodeOrder order) {
+    switch (order) {
+    case NodeOrder::Bfs:
+        return "/bfs";
+    case NodeOrder::ReverseCuthillMcKee:
+        return "/rcm";
+    case NodeOrder::Degree:
+        return "/degree";
+    default:
+        return "";
+    }
+}
+
+/**
+ * @brief Random sparse graph: each node gets degree random arcs with capacities in [1, 1000].
+ *        With Engine::ParallelPushRelabel the same instance is solved by push_relabel() on threads threads,
+ *        and likewise by the other engines. order renumbers the nodes internally, see BasicIsap::set_node_order.
+ */
+static Benchmark random_sparse(int n, int degree, Engine engine = Engine::Isap, int threads = 1,
+                               NodeOrder order = NodeOrder::Given) {
+    string suffix = engine_suffix(engine, threads) + order_suffix(order);
+    return {"random_sparse/" + to_string(n) + "/" + to_string(degree) + suffix, [=](int repetitions, BenchmarkResult& result) {
+        mt19937 rng(1);
+        Isap graph(n);
+        graph.set_node_order(order, n - 1);
+        for (int u = 0; u < n; u++) {
+            for (int k = 0; k < degree; k++) {
+                graph.add_edge(u, rng() % n, 1 + rng() % 1000);
+            }
+        }
+        time_solve(graph, n, 0, n - 1, repetitions, result, engine, threads);
+    }};
+}
+
+/**
+ * @brief Bipartite matching with side nodes on each side, each left node adjacent to each right node with probability percent%.
+ *        With another engine the same instance is solved by it, e.g. unit_capacity_flow() for Engine::UnitCapacity.
+ */
+static Benchmark dense_bipartite(int side, int percent, Engine engine = Engine::Isap) {
+    string suffix = engine_suffix(engine);
+    return {"dense_bipartite/" + to_string(side) + "/" + to_string(percent) + suffix, [=](int repetitions, BenchmarkResult& result) {
+        mt19937 rng(2);
+        int n = 2 * side + 2, s = n - 2, t = n - 1;
+        Isap graph(n);
+        for (int i = 0; i < side; i++) {
+            graph.add_edge(s, i, 1);
+            graph.add_edge(side + i, t, 1);
+        }
+        for (int i = 0; i < side; i++) {
+            for (int j = 0; j < side; j++) {
+                if ((int)(rng() % 100) < percent) graph.add_edge(i, side + j, 1);
+            }
+        }
+        time_solve(graph, n, s, t, repetitions, result, engine);
+    }};
+}
+
+/**
+ * @brief Image segmentation grid: 4-neighbour smoothness arcs plus a source and a sink arc per pixel.
+ *        With shuffled the pixels get random ids, as from an upstream system that numbers them arbitrarily;
+ *        order renumbers the nodes internally, see BasicIsap::set_node_order.
+ */
+static Benchmark segmentation(int width, int height, bool shuffled = false, NodeOrder order = NodeOrder::Given) {
+    string suffix = (shuffled ? "/shuffled" : "") + order_suffix(order);
+    return {"segmentation/" + to_string(width) + "x" + to_string(height) + suffix, [=](int repetitions, BenchmarkResult& result) {
+        mt19937 rng(3);
+        int n = width * height + 2, s = n - 2, t = n - 1;
+        vector<int> id(width * height);
+        for (int u = 0; u < width * height; u++) id[u] = u;
+        if (shuffled) shuffle(id.begin(), id.end(), mt19937(4));
+        Isap graph(n);
+        graph.set_node_order(order, t);
+        for (int x = 0; x < width; x++) {
+            for (int y = 0; y < height; y++) {
+                int u = x * height + y;
+                if (x + 1 < width) {
+                    int c = 1 + rng() % 50;
+                    graph.add_edge(id[u], id[u + height], c);
+                    graph.add_edge(id[u + height], id[u], c);
+                }
+                if (y + 1 < height) {
+                    int c = 1 + rng() % 50;
+                    graph.add_edge(id[u], id[u + 1], c);
+                    graph.add_edge(id[u + 1], id[u], c);
+                }
+                graph.add_edge(s, id[u], rng() % 100);
+                graph.add_edge(id[u], t, rng() % 100);
+            }
+        }
+        time_solve(graph, n, s, t, repetitions, result);
+    }};
+}
+
+/**
+ * @brief A width x height grid whose arcs point right and up/down, with the source attached to the left column and the
+ *        sink to the right column, so augmenting paths are at least width arcs long. Solved with the given AugmentMode,
+ *        and with partitioned, with saturated arcs kept out of the scans (see BasicIsap::set_arc_partitioning).
+ */
+static Benchmark long_grid(int width, int height, AugmentMode mode, bool partitioned = false) {
+    string suffix = string(mode == AugmentMode::Restart ? "/restart" : "/retreat") + (partitioned ? "/partitioned" : "");
+    return {"long_grid/" + to_string(width) + "x" + to_string(height) + suffix, [=](int repetitions, BenchmarkResult& result) {
+        mt19937 rng(7);
+        int n = width * height + 2, s = n - 2, t = n - 1;
+        Isap graph(n);
+        for (int x = 0; x < width; x++) {
+            for (int y = 0; y < height; y++) {
+                int u = x * height + y;
+                if (x + 1 < width) graph.add_edge(u, u + height, 1 + rng() % 100);
+                if (y + 1 < height) graph.add_edge(u, u + 1, 1 + rng() % 100);
+                if (y > 0) graph.add_edge(u, u - 1, 1 + rng() % 100);
+            }
+        }
+        for (int y = 0; y < height; y++) {
+            graph.add_edge(s, y, INF);
+            graph.add_edge((width - 1) * height + y, t, INF);
+        }
+        graph.set_augment_mode(mode);
+        graph.set_arc_partitioning(partitioned);
+        time_solve(graph, n, s, t, repetitions, result);
+    }};
+}
+
+/**
+ * @brief A "broom": a handle of length nodes ending in fan unit-capacity branches to the sink.
+ *        Every augmenting path shares the whole handle. Solved with the given AugmentMode.
+ */
+static Benchmark broom(int length, int fan, AugmentMode mode) {
+    string suffix = mode == AugmentMode::Restart ? "/restart" : "/retreat";
+    return {"broom/" + to_string(length) + "/" + to_string(fan) + suffix, [=](int repetitions, BenchmarkResult& result) {
+        int n = length + fan + 2, s = n - 2, t = n - 1;
+        Isap graph(n);
+        graph.add_edge(s, 0, INF);
+        for (int i = 0; i + 1 < length; i++) {
+            graph.add_edge(i, i + 1, INF);
+        }
+        for (int k = 0; k < fan; k++) {
+            graph.add_edge(length - 1, length + k, 1);
+            graph.add_edge(length + k, t, 1);
+        }
+        graph.set_augment_mode(mode);
+        time_solve(graph, n, s, t, repetitions, result);
+    }};
+}
+
+/**
+ * @brief Layered worst case in the spirit of the AK generator: a spine s -> a_1 -> ... -> a_k, where a_i leaves to the
+ *        sink through a unit-capacity chain of length i. Shortest augmenting paths use the chains from the shortest up,
+ *        and the spine is relabelled once per chain, for Theta(k^2) relabels.
+ */
+static Benchmark layered(int k) {
+    return {"layered/" + to_string(k), [=](int repetitions, BenchmarkResult& result) {
+        int n = k + k * (k + 1) / 2 + 2, s = n - 2, t = n - 1;
+        Isap graph(n);
+        graph.add_edge(s, 0, k);
+        for (int i = 0; i + 1 < k; i++) {
+            graph.add_edge(i, i + 1, k);
+        }
+        int next = k;
+        for (int i = 0; i < k; i++) {
+            int u = i;
+            for (int j = 0; j <= i; j++) {
+                graph.add_edge(u, next, 1);
+                u = next++;
+            }
+            graph.add_edge(u, t, 1);
+        }
+        time_solve(graph, n, s, t, repetitions, result);
+    }};
+}
+
+/**
+ * @brief Lower-bound network for has_feasible_flow: paths of a planted s-t flow set the lower bounds, so the instance is
+ *        feasible, and random extra edges with slack capacity are mixed in. With streamed the edges go straight into
+ *        an Isap through add_bounded_edge and feasible_flow() solves it, so no vector of OriginalEdge is held.
+ */
+static Benchmark lower_bound(int n, int paths, bool streamed = false) {
+    string suffix = streamed ? "/streamed" : "";
+    return {"lower_bound/" + to_string(n) + "/" + to_string(paths) + suffix, [=](int repetitions, BenchmarkResult& result) {
+        // Calls add(u, v, lower, upper) for every edge of the instance.
+        auto generate = [=](const function<void(int, int, int, int)>& add) {
+            mt19937 rng(5);
+            for (int p = 0; p < paths; p++) {
+                int u = 0, f = 1 + rng() % 10;
+                for (int hop = 0; hop < 6; hop++) {
+                    int v = hop == 5 ? n - 1 : 1 + rng() % (n - 2);
+                    add(u, v, f / 2, f + (int)(rng() % 10));
+                    u = v;
+                }
+            }
+            for (int i = 0; i < 2 * paths; i++) {
+                int u = rng() % n, v = rng() % n;
+                add(u, v, 0, (int)(rng() % 20));
+            }
+        };
+        vector<OriginalEdge> edges;
+        if (!streamed) generate([&](int u, int v, int lower, int upper) { edges.push_back({u, v, lower, upper}); });
+        result.nodes = n;
+        result.edges = 8LL * paths;
+        double total = 0;
+        for (int r = 0; r < repetitions; r++) {
+            auto start = chrono::steady_clock::now();
+            if (streamed) {
+                Isap graph(n, 8 * paths + 1);
+                generate([&](int u, int v, int lower, int upper) { graph.add_bounded_edge(u, v, lower, upper); });
+                result.flow = graph.feasible_flow(0, n - 1) >= 0;
+            } else {
+                result.flow = has_feasible_flow(n, 0, n - 1, edges);
+            }
+            total += chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        }
+        result.ns = total / repetitions;
+    }};
+}
+
+/**
+ * @brief A long width x height strip like long_grid, with 64-bit capacities spread log-uniformly over [1, 10^12] on
+ *        its grid arcs, so long augmenting paths have a wide range of bottlenecks; with scaling solved by capacity
+ *        scaling, see BasicIsap::set_capacity_scaling.
+ */
+static Benchmark wide_capacities(int width, int height, bool scaling) {
+    string suffix = scaling ? "/scaling" : "";
+    return {"wide_capacities/" + to_string(width) + "x" + to_string(height) + suffix, [=](int repetitions, BenchmarkResult& result) {
+        mt19937 rng(8);
+        int n = width * height + 2, s = width * height, t = s + 1;
+        BasicIsap<long long> graph(n);
+        graph.set_capacity_scaling(scaling);
+        auto wide = [&]() {
+            long long cap = 1;
+            for (int digits = rng() % 13; digits > 0; digits--) cap *= 10;
+            return cap + (long long)(rng() % cap);
+        };
+        auto id = [=](int x, int y) { return y * width + x; };
+        for (int y = 0; y < height; y++) {
+            graph.add_edge(s, id(0, y), CapTraits<long long>::inf());
+            graph.add_edge(id(width - 1, y), t, CapTraits<long long>::inf());
+            for (int x = 0; x < width; x++) {
+                if (x + 1 < width) graph.add_edge(id(x, y), id(x + 1, y), wide());
+                if (y + 1 < height) {
+                    graph.add_edge(id(x, y), id(x, y + 1), wide());
+                    graph.add_edge(id(x, y + 1), id(x, y), wide());
+                }
+            }
+        }
+        result.nodes = n;
+        result.edges = graph.edge_count();
+        double total = 0;
+        for (int r = 0; r < repetitions; r++) {
+            graph.reset_flows();
+            graph.reset_stats();
+            auto start = chrono::steady_clock::now();
+            result.flow = graph.isap(s, t);
+            total += chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        }
+        result.ns = total / repetitions;
+        if (BasicIsap<long long>::stats_enabled()) {
+            result.augmentations = graph.stats().augmentations;
+            result.relabels = graph.stats().relabels;
+        }
+    }};
+}
+
+/**
+ * @brief A random sparse network that changes between solves: each repetition applies a batch of batch random
+ *        updates (capacity changes, half of them below the current flow, removals and insertions), timed through
+ *        apply_updates(). With resolve the same batches are applied to the graph and it is solved again with isap().
+ */
+static Benchmark dynamic_updates(int n, int degree, int batch, bool resolve) {
+    string suffix = resolve ? "/resolve" : "/apply";
+    return {"dynamic_updates/" + to_string(n) + "/" + to_string(batch) + suffix, [=](int repetitions, BenchmarkResult& result) {
+        mt19937 rng(6);
+        Isap graph(n);
+        for (int u = 0; u < n; u++) {
+            for (int k = 0; k < degree; k++) {
+                graph.add_edge(u, rng() % n, 1 + rng() % 1000);
+            }
+        }
+        result.flow = graph.isap(0, n - 1);
+        double total = 0;
+        for (int r = 0; r < repetitions; r++) {
+            vector<EdgeUpdate> updates;
+            for (int k = 0; k < batch; k++) {
+                int id = rng() % graph.edge_count(), kind = rng() % 4;
+                if (kind == 0) {
+                    updates.push_back({UpdateKind::SetCapacity, id, 0, 0, graph.get_edge(id).flow / 2});
+                } else if (kind == 1) {
+                    updates.push_back({UpdateKind::SetCapacity, id, 0, 0, 1 + (int)(rng() % 1000)});
+                } else if (kind == 2) {
+                    updates.push_back({UpdateKind::Remove, id, 0, 0, 0});
+                } else {
+                    updates.push_back({UpdateKind::Insert, -1, (int)(rng() % n), (int)(rng() % n), 1 + (int)(rng() % 1000)});
+                }
+            }
+            auto start = chrono::steady_clock::now();
+            if (resolve) {
+                graph.reset_flows();
+                for (const EdgeUpdate& u : updates) {
+                    if (u.kind == UpdateKind::Insert) {
+                        graph.add_edge(u.from, u.to, u.cap);
+                    } else {
+                        graph.set_capacity(u.id, u.kind == UpdateKind::Remove ? 0 : u.cap);
+                    }
+                }
+                result.flow = graph.isap(0, n - 1);
+            } else {
+                result.flow += graph.apply_updates(updates, 0, n - 1);
+            }
+            total += chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        }
+        result.nodes = n;
+        result.edges = graph.edge_count();
+        result.ns = total / repetitions;
+    }};
+}
+
+/**
+ * @brief Random sparse graph with costs: each node gets degree random arcs with capacities in [1, 1000] and costs in
+ *        [0, max_cost], solved by min_cost_flow(). Few distinct costs mean many shortest paths per phase.
+ */
+static Benchmark min_cost_sparse(int n, int degree, int max_cost) {
+    return {"min_cost_sparse/" + to_string(n) + "/" + to_string(degree) + "/" + to_string(max_cost),
+            [=](int repetitions, BenchmarkResult& result) {
+        mt19937 rng(7);
+        Isap graph(n);
+        for (int u = 0; u < n; u++) {
+            for (int k = 0; k < degree; k++) {
+                graph.add_edge(u, rng() % n, 1 + rng() % 1000, rng() % (max_cost + 1));
+            }
+        }
+        result.nodes = n;
+        result.edges = graph.edge_count();
+        double total = 0;
+        for (int r = 0; r < repetitions; r++) {
+            auto start = chrono::steady_clock::now();
+            result.flow = graph.min_cost_flow(0, n - 1).first;
+            total += chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        }
+        result.ns = total / repetitions;
+    }};
+}
+
+/**
+ * @brief Runs one benchmark in a child process and collects its results and peak memory.
+ */
+static bool run_isolated(const Benchmark& benchmark, int repetitions, BenchmarkResult& result) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        benchmark.run(repetitions, result);
+        if (write(fds[1], &result, sizeof(result)) != sizeof(result)) _exit(1);
+        _exit(0);
+    }
+    close(fds[1]);
+    bool ok = read(fds[0], &result, sizeof(result)) == sizeof(result);
+    close(fds[0]);
+    int status;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    result.peak_rss_kb = usage.ru_maxrss;
+    return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char** argv) {
+    string filter;
+    int repetitions = 3;
+    bool json = false;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--filter=", 9) == 0) {
+            filter = argv[i] + 9;
+        } else if (strncmp(argv[i], "--repetitions=", 14) == 0) {
+            repetitions = max(1, atoi(argv[i] + 14));
+        } else if (strcmp(argv[i], "--format=json") == 0) {
+            json = true;
+        } else {
+            fprintf(stderr, "usage: %s [--filter=<substring>] [--repetitions=<n>] [--format=json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    vector<Benchmark> benchmarks = {
+        random_sparse(100000, 8),
+        random_sparse(400000, 4),
+        random_sparse(400000, 4, Engine::PrunedIsap),
+        random_sparse(100000, 8, Engine::HighestLabel),
+        random_sparse(100000, 8, Engine::ParallelPushRelabel, 1),
+        random_sparse(100000, 8, Engine::ParallelPushRelabel, 8),
+        random_sparse(400000, 4, Engine::Isap, 1, NodeOrder::Bfs),
+        random_sparse(400000, 4, Engine::Isap, 1, NodeOrder::ReverseCuthillMcKee),
+        random_sparse(400000, 4, Engine::Isap, 1, NodeOrder::Degree),
+        dense_bipartite(1000, 20),
+        dense_bipartite(2000, 10),
+        dense_bipartite(1000, 20, Engine::UnitCapacity),
+        dense_bipartite(2000, 10, Engine::UnitCapacity),
+        dense_bipartite(1000, 20, Engine::HighestLabel),
+        dense_bipartite(2000, 10, Engine::HighestLabel),
+        segmentation(256, 256),
+        segmentation(512, 512),
+        segmentation(512, 512, true),
+        segmentation(512, 512, true, NodeOrder::Bfs),
+        segmentation(512, 512, true, NodeOrder::ReverseCuthillMcKee),
+        segmentation(512, 512, true, NodeOrder::Degree),
+        layered(300),
+        long_grid(3000, 10, AugmentMode::Restart),
+        long_grid(3000, 10, AugmentMode::Retreat),
+        long_grid(3000, 10, AugmentMode::Retreat, true),
+        broom(5000, 5000, AugmentMode::Restart),
+        broom(5000, 5000, AugmentMode::Retreat),
+        lower_bound(10000, 20000),
+        lower_bound(100000, 200000),
+        lower_bound(100000, 200000, true),
+        dynamic_updates(100000, 8, 100, false),
+        dynamic_updates(100000, 8, 100, true),
+        wide_capacities(3000, 10, false),
+        wide_capacities(3000, 10, true),
+        min_cost_sparse(20000, 8, 10),
+        min_cost_sparse(20000, 8, 1000),
+    };
+
+    if (json) {
+        printf("{\n  \"context\": {\"library\": \"isap\", \"repetitions\": %d},\n  \"benchmarks\": [", repetitions);
+    } else {
+        printf("%-40s %10s %10s %12s %10s %12s %12s %12s\n", "benchmark", "nodes", "edges", "time ms", "ns/edge",
+               "augments", "relabels", "peak KB");
+    }
+    bool first = true;
+    for (const auto& benchmark : benchmarks) {
+        if (benchmark.name.find(filter) == string::npos) continue;
+        BenchmarkResult result;
+        if (!run_isolated(benchmark, repetitions, result)) {
+            fprintf(stderr, "%s failed\n", benchmark.name.c_str());
+            return 1;
+        }
+        double ns_per_edge = result.edges > 0 ? result.ns / result.edges : 0;
+        if (json) {
+            printf("%s\n    {\"name\": \"%s\", \"iterations\": %d, \"real_time\": %.0f, \"time_unit\": \"ns\", "
+                   "\"nodes\": %d, \"edges\": %lld, \"ns_per_edge\": %.3f, \"flow\": %lld, \"augmentations\": %lld, "
+                   "\"relabels\": %lld, \"peak_rss_kb\": %ld}",
+                   first ? "" : ",", benchmark.name.c_str(), repetitions, result.ns, result.nodes, result.edges,
+                   ns_per_edge, result.flow, result.augmentations, result.relabels, result.peak_rss_kb);
+        } else {
+            printf("%-40s %10d %10lld %12.2f %10.2f %12lld %12lld %12ld\n", benchmark.name.c_str(), result.nodes,
+                   result.edges, result.ns / 1e6, ns_per_edge, result.augmentations, result.relabels, result.peak_rss_kb);
+        }
+        fflush(stdout);
+        first = false;
+    }
+    if (json) {
+        printf("\n  ]\n}\n");
+    }
+    return 0;
+}
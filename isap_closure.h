@@ -0,0 +1,19 @@
+#ifndef ISAP_CLOSURE_H
+#define ISAP_CLOSURE_H
+
+#include "isap.h"
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+struct ClosureResult {
+    // weight: The total weight of the closure.
+    // vertices: The vertices in the closure, in increasing order.
+    long long weight;
+    vector<int> vertices;
+};
+
+ClosureResult max_weight_closure(const vector<long long>& weights, const vector<pair<int, int>>& deps);
+
+#endif // ISAP_CLOSURE_H
@@ -0,0 +1,62 @@
+#include "isap_closure.h"
+#include <cassert>
+#include <random>
+
+int main() {
+  // Test case 1: Project selection; project 0 needs tools 2 and 3, project 1 needs tool 3
+  ClosureResult result1 = max_weight_closure({10, 4, -3, -6}, {{0, 2}, {0, 3}, {1, 3}});
+  assert(result1.weight == 5);
+  assert((result1.vertices == vector<int>{0, 1, 2, 3}));
+
+  // Test case 2: Nothing is worth choosing
+  ClosureResult result2 = max_weight_closure({1, -5}, {{0, 1}});
+  assert(result2.weight == 0);
+  assert(result2.vertices.empty());
+
+  // Test case 3: Weights whose sum needs 64-bit residuals
+  ClosureResult result3 = max_weight_closure({3000000000LL, 3000000000LL, -1}, {{0, 2}});
+  assert(result3.weight == 5999999999LL);
+  assert((result3.vertices == vector<int>{0, 1, 2}));
+
+  // Test case 4: A negative weight beyond 32 bits next to 32-bit positive weights
+  ClosureResult result4 = max_weight_closure({5, -(1LL << 32)}, {{0, 1}});
+  assert(result4.weight == 0);
+  assert(result4.vertices.empty());
+
+  // Test case 5: Matches brute force on small random instances
+  mt19937 rng(4);
+  for (int round = 0; round < 50; round++) {
+    int n = 8;
+    vector<long long> weights(n);
+    for (auto& w : weights) w = (int)(rng() % 21) - 10;
+    vector<pair<int, int>> deps;
+    for (int i = 0; i < 10; i++) deps.push_back({rng() % n, rng() % n});
+    long long best = 0;
+    for (int mask = 0; mask < (1 << n); mask++) {
+      bool closed = true;
+      for (auto& dep : deps) {
+        if ((mask >> dep.first & 1) && !(mask >> dep.second & 1)) closed = false;
+      }
+      if (!closed) continue;
+      long long weight = 0;
+      for (int v = 0; v < n; v++) {
+        if (mask >> v & 1) weight += weights[v];
+      }
+      best = max(best, weight);
+    }
+    ClosureResult result = max_weight_closure(weights, deps);
+    assert(result.weight == best);
+    long long weight = 0;
+    vector<bool> chosen(n, false);
+    for (int v : result.vertices) {
+      chosen[v] = true;
+      weight += weights[v];
+    }
+    assert(weight == best);
+    for (auto& dep : deps) {
+      assert(!chosen[dep.first] || chosen[dep.second]);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef ISAP_FEASIBLE_FLOW_H
+#define ISAP_FEASIBLE_FLOW_H
+
+#include "isap.h"
+#include <vector>
+
+using namespace std;
+
+struct OriginalEdge {
+    // u, v: The start and end vertices of the edge.
+    // lower: The minimum flow required on this edge.
+    // upper: The maximum flow allowed on this edge.
+    int u, v, lower, upper;
+};
+
+/**
+ * @brief A flow network with lower and upper bounds, solved once by Isap::feasible_flow in a graph that is kept alive,
+ *        so that the maximum or minimum feasible s-t flow is computed in the same residual graph.
+ *        The graph holds the edges once, with lower bounds folded into node demands; callers that can stream their
+ *        edges use Isap::add_bounded_edge directly and need no vector of OriginalEdge at all.
+ */
+class FeasibleFlow {
+public:
+    FeasibleFlow(int n, int s, int t, const vector<OriginalEdge>& edges);
+    bool feasible() const;
+    int flow_value() const;
+    int edge_flow(int i) const;
+    int max_flow();
+    int min_flow();
+
+private:
+    int s, t;
+    bool is_feasible;
+    // The s-t value of the current feasible flow.
+    int value;
+    // The edges, with the same ids as in the caller's vector.
+    Isap graph;
+};
+
+bool has_feasible_flow(int n, int s, int t, const vector<OriginalEdge>& edges);
+
+#endif // ISAP_FEASIBLE_FLOW_H
@@ -0,0 +1,26 @@
+#include "isap_feasible_flow.h"
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    int n = 4;
+    int s = 0;
+    int t = 3;
+    vector<OriginalEdge> edges = {
+        {0, 1, 2, 5},
+        {0, 2, 1, 3},
+        {1, 3, 1, 3},
+        {2, 3, 2, 4}
+    };
+    FeasibleFlow flow(n, s, t, edges);
+    bool feasible = flow.feasible();
+    if(feasible){
+        cout << "Sample has a feasible flow." << endl;
+        cout << "Maximum feasible flow: " << flow.max_flow() << endl;
+        cout << "Minimum feasible flow: " << flow.min_flow() << endl;
+    }else{
+        cout << "Sample does not have a feasible flow." << endl;
+    }
+    return 0;
+}
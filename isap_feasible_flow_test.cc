@@ -0,0 +1,170 @@
+#include "isap_feasible_flow.h"
+#include <cassert>
+#include <random>
+
+/**
+ * @brief The maximum and minimum feasible s-t values by the textbook reduction in an explicit n+2 node graph, with
+ *        SS, TT and (t, s) arcs, or {-1, -1} if there is no feasible flow: the reference for FeasibleFlow.
+ */
+static pair<int, int> reference_bounds(int n, int s, int t, const vector<OriginalEdge>& edges) {
+    Isap aux(n + 2);
+    vector<int> demand(n, 0);
+    for (const auto& edge : edges) {
+        if (edge.lower > edge.upper) return {-1, -1};
+        aux.add_edge(edge.u, edge.v, edge.upper - edge.lower);
+        demand[edge.u] -= edge.lower;
+        demand[edge.v] += edge.lower;
+    }
+    int needed = 0;
+    for (int v = 0; v < n; v++) {
+        if (demand[v] > 0) {
+            aux.add_edge(n, v, demand[v]);
+            needed += demand[v];
+        } else if (demand[v] < 0) {
+            aux.add_edge(v, n + 1, -demand[v]);
+        }
+    }
+    int back = aux.add_edge(t, s, INF);
+    if (aux.isap(n, n + 1) != needed) return {-1, -1};
+    int value = aux.get_edge(back).flow;
+    aux.remove_edge(back);
+    int high = value + aux.augment(s, t);
+    int low = high - aux.augment(t, s);
+    return {high, low};
+}
+
+/**
+ * @brief Checks that the flow in g lies within the bounds of edges and is conserved at every node but s and t, and
+ *        returns its s-t value.
+ */
+static long long check_bounds(const BasicIsap<long long>& g, int n, int s, int t, const vector<OriginalEdge>& edges) {
+    vector<long long> balance(n, 0);
+    for (int i = 0; i < (int)edges.size(); i++) {
+        auto e = g.get_edge(i);
+        assert(e.cap == edges[i].upper && e.flow >= edges[i].lower && e.flow <= edges[i].upper);
+        balance[edges[i].u] -= e.flow;
+        balance[edges[i].v] += e.flow;
+    }
+    for (int v = 0; v < n; v++) {
+        if (v != s && v != t) assert(balance[v] == 0);
+    }
+    return balance[t];
+}
+
+int main() {
+    // Test case 1: Feasible flow
+    int n1 = 4;
+    int s1 = 0;
+    int t1 = 3;
+    vector<OriginalEdge> edges1 = {
+        {0, 1, 5, 10},
+        {0, 2, 2, 8},
+        {1, 3, 3, 6},
+        {2, 3, 4, 9}
+    };
+    assert(has_feasible_flow(n1, s1, t1, edges1));
+
+    // Test case 2: Infeasible flow (lower > upper)
+    int n2 = 3;
+    int s2 = 0;
+    int t2 = 2;
+    vector<OriginalEdge> edges2 = {
+        {0, 1, 5, 3},
+        {1, 2, 1, 4},
+    };
+    assert(!has_feasible_flow(n2, s2, t2, edges2));
+    // Test case 3: Infeasible flow (not enough capacity)
+    int n3 = 4;
+    int s3 = 0;
+    int t3 = 3;
+    vector<OriginalEdge> edges3 = {
+        {0, 1, 6, 10}, {0, 2, 4, 8}, {1, 3, 1, 3}, {2, 3, 2, 3}
+    };
+    assert(!has_feasible_flow(n3, s3, t3, edges3));
+
+    // Test case 4: Feasible flow
+    int n4 = 4;
+    int s4 = 0;
+    int t4 = 3;
+    vector<OriginalEdge> edges4 = {
+        {0, 1, 2, 5},
+        {0, 2, 1, 3},
+        {1, 3, 1, 3},
+        {2, 3, 2, 4}
+    };
+    assert(has_feasible_flow(n4, s4, t4, edges4));
+
+    // Test case 5: Maximum and minimum feasible flow of test case 1, in the same residual graph
+    FeasibleFlow flow5(n1, s1, t1, edges1);
+    assert(flow5.feasible());
+    assert(flow5.max_flow() == 14);
+    assert(flow5.edge_flow(0) == 6 && flow5.edge_flow(2) == 6);
+    assert(flow5.min_flow() == 9);
+    for (int i = 0; i < (int)edges1.size(); i++) {
+        assert(flow5.edge_flow(i) >= edges1[i].lower && flow5.edge_flow(i) <= edges1[i].upper);
+    }
+    assert(flow5.edge_flow(0) + flow5.edge_flow(1) == flow5.flow_value());
+    assert(flow5.max_flow() == 14);
+
+    // Test case 6: Fixed edges and an edge back into s; the minimum net s-t value is negative
+    vector<OriginalEdge> edges6 = {{0, 1, 3, 3}, {1, 2, 2, 5}, {2, 0, 0, 4}, {1, 0, 1, 1}};
+    FeasibleFlow flow6(3, 0, 2, edges6);
+    assert(flow6.feasible());
+    assert(flow6.edge_flow(0) == 3 && flow6.edge_flow(3) == 1);
+    assert(flow6.max_flow() == 2);
+    assert(flow6.edge_flow(2) == 0);
+    assert(flow6.min_flow() == -2);
+    assert(flow6.edge_flow(1) == 2 && flow6.edge_flow(2) == 4);
+    FeasibleFlow flow7(n3, s3, t3, edges3);
+    assert(!flow7.feasible());
+
+    // Test case 7: Random networks agree with the explicit n+2 node reduction, in both augment modes, under a node
+    // order and with arc partitioning, and the solver's flow respects every bound at each step
+    mt19937 rng(28);
+    for (int round = 0; round < 300; round++) {
+        int n = 2 + rng() % 15, m = rng() % 40;
+        int s = rng() % n, t = (s + 1 + rng() % (n - 1)) % n;
+        vector<OriginalEdge> edges;
+        for (int i = 0; i < m; i++) {
+            int lower = rng() % 3 == 0 ? rng() % 4 : 0;
+            edges.push_back({(int)(rng() % n), (int)(rng() % n), lower, lower + (int)(rng() % 8) - (round % 50 == 0)});
+        }
+        pair<int, int> expected = reference_bounds(n, s, t, edges);
+        FeasibleFlow flow(n, s, t, edges);
+        assert(flow.feasible() == (expected.first >= 0));
+        if (flow.feasible()) {
+            assert(flow.max_flow() == expected.first);
+            assert(flow.min_flow() == expected.second);
+        }
+
+        BasicIsap<long long> g(n);
+        if (round % 4 == 1) g.set_augment_mode(AugmentMode::Restart);
+        if (round % 4 == 2) g.set_node_order(NodeOrder::Bfs, t);
+        if (round % 4 == 3) g.set_arc_partitioning(true);
+        for (const auto& edge : edges) {
+            g.add_bounded_edge(edge.u, edge.v, edge.lower, edge.upper);
+        }
+        long long value = g.feasible_flow(s, t);
+        assert((value >= 0) == (expected.first >= 0));
+        if (value < 0) continue;
+        assert(check_bounds(g, n, s, t, edges) == value);
+        assert(value + g.augment(s, t) == expected.first);
+        assert(check_bounds(g, n, s, t, edges) == expected.first);
+        // A repeated call reuses its (t, s) edge instead of adding another one
+        int edge_count = g.edge_count();
+        value = g.feasible_flow(s, t);
+        assert(value >= 0 && g.edge_count() == edge_count);
+        assert(check_bounds(g, n, s, t, edges) == value);
+    }
+
+    // Test case 8: With 32-bit residuals the (t, s) edge is clamped to the largest residual, not truncated
+    BasicIsap<long long, uint32_t> narrow(4);
+    narrow.add_bounded_edge(0, 1, 3000000000LL, 4000000000LL);
+    narrow.add_bounded_edge(1, 3, 0, 4000000000LL);
+    narrow.add_bounded_edge(0, 2, 1, 5);
+    narrow.add_bounded_edge(2, 3, 2, 5);
+    assert(narrow.feasible_flow(0, 3) == 3000000002LL);
+    assert(narrow.feasible_flow(0, 3) == 3000000002LL);
+    cout << "All test cases passed!" << endl;
+    return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef ISAP_GOMORY_HU_H
+#define ISAP_GOMORY_HU_H
+
+#include "isap.h"
+#include <vector>
+
+using namespace std;
+
+struct UndirectedEdge {
+    int u;
+    int v;
+    long long cap;
+};
+
+/**
+ * @brief A Gomory-Hu tree: the minimum cut between any two nodes is the lightest edge on their tree path.
+ *        Node 0 is the root; every other node v hangs off parent[v] by an edge of weight weight[v].
+ */
+struct GomoryHuTree {
+    vector<int> parent;
+    vector<long long> weight;
+
+    long long min_cut(int u, int v) const;
+};
+
+GomoryHuTree gomory_hu_tree(int n, const vector<UndirectedEdge>& edges, int threads = 1);
+
+#endif // ISAP_GOMORY_HU_H
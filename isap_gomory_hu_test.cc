@@ -0,0 +1,42 @@
+#include "isap_gomory_hu.h"
+#include <cassert>
+#include <random>
+
+int main() {
+  // Test case 1: A path 0 - 1 - 2 with a weak last link
+  GomoryHuTree tree1 = gomory_hu_tree(3, {{0, 1, 5}, {1, 2, 2}});
+  assert(tree1.min_cut(0, 1) == 5);
+  assert(tree1.min_cut(0, 2) == 2);
+  assert(tree1.min_cut(2, 1) == 2);
+
+  // Test case 2: A disconnected node is cut from everything for free
+  GomoryHuTree tree2 = gomory_hu_tree(3, {{0, 1, 4}});
+  assert(tree2.min_cut(0, 1) == 4);
+  assert(tree2.min_cut(1, 2) == 0);
+
+  // Test case 3: Every pair matches a direct maximum flow, and speculative parallel cuts build the same tree
+  mt19937 rng(3);
+  for (int round = 0; round < 20; round++) {
+    int n = 12;
+    vector<UndirectedEdge> edges;
+    for (int i = 0; i < 30; i++) {
+      edges.push_back({(int)(rng() % n), (int)(rng() % n), (long long)(rng() % 10)});
+    }
+    GomoryHuTree tree = gomory_hu_tree(n, edges);
+    GomoryHuTree parallel = gomory_hu_tree(n, edges, 4);
+    assert(tree.parent == parallel.parent);
+    assert(tree.weight == parallel.weight);
+    for (int u = 0; u < n; u++) {
+      for (int v = u + 1; v < n; v++) {
+        BasicIsap<long long> direct(n);
+        for (const auto& e : edges) {
+          direct.add_edge(e.u, e.v, e.cap);
+          direct.add_edge(e.v, e.u, e.cap);
+        }
+        assert(tree.min_cut(u, v) == direct.isap(u, v));
+      }
+    }
+  }
+
+  return 0;
+}
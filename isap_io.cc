@@ -0,0 +1,408 @@
+#include "isap_io.h"
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * @brief A read-only memory mapping of a whole file, unmapped on destruction.
+ *        The pages are read by the kernel on first access, so a file is never copied into a buffer first.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                madvise(p, st.st_size, MADV_SEQUENTIAL);
+                data = static_cast<const char*>(p);
+                size = st.st_size;
+            }
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data) munmap(const_cast<char*>(data), size);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+/**
+ * @brief Whether an edge read from a file is valid for a solver on n nodes whose residuals are stored as Res.
+ */
+template <typename Res>
+static bool valid_edge(int n, long long u, long long v, long long cap) {
+    return u >= 0 && u < n && v >= 0 && v < n && cap >= 0 && (long double)cap <= (long double)numeric_limits<Res>::max();
+}
+
+/**
+ * @brief Loads a graph in the binary format of BinaryGraphHeader into solver, replacing its edges (see clear()).
+ *        The file is memory-mapped once, the solver is reserved for m edges, and each edge is validated and appended
+ *        with add_edge straight from the mapped arrays, so the edge list is never copied into a buffer of its own.
+ * @param path The file to read.
+ * @param solver The solver to fill.
+ * @param s, t Receive the source and sink stored in the file.
+ * @return false if the file cannot be read, is not in the format, or holds an edge whose nodes or capacity are
+ *         out of range for the solver; solver is then left empty or partially filled.
+ * @note Time Complexity: O(V + E), a single sequential pass over the file.
+ */
+template <typename Cap, typename Res>
+bool load_binary_graph(const string& path, BasicIsap<Cap, Res>& solver, int& s, int& t) {
+    MappedFile file(path);
+    BinaryGraphHeader header;
+    if (file.size < sizeof(header)) return false;
+    memcpy(&header, file.data, sizeof(header));
+    if (memcmp(header.magic, "ISAPBIN1", 8) != 0 || header.n < 0 ||
+        header.m > (file.size - sizeof(header)) / 16 || file.size != sizeof(header) + 16 * header.m ||
+        header.m > (uint64_t)numeric_limits<int>::max()) {
+        return false;
+    }
+    int n = header.n;
+    if (header.s < 0 || header.s >= n || header.t < 0 || header.t >= n) return false;
+    const int32_t* from = reinterpret_cast<const int32_t*>(file.data + sizeof(header));
+    const int32_t* to = from + header.m;
+    const int64_t* cap = reinterpret_cast<const int64_t*>(to + header.m);
+    solver.clear(n);
+    solver.reserve(header.m);
+    for (uint64_t i = 0; i < header.m; i++) {
+        if (!valid_edge<Res>(n, from[i], to[i], cap[i])) return false;
+        solver.add_edge(from[i], to[i], (Cap)cap[i]);
+    }
+    s = header.s;
+    t = header.t;
+    return true;
+}
+
+/**
+ * @brief Parses a non-negative decimal integer at p, skipping spaces and tabs before it.
+ *        Returns false if there is none or it does not fit in a long long.
+ */
+static bool parse_number(const char*& p, const char* end, long long& value) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    if (p == end || *p < '0' || *p > '9') return false;
+    value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (value > (numeric_limits<long long>::max() - 9) / 10) return false;
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    return true;
+}
+
+/**
+ * @brief Loads a DIMACS max-flow file into solver, replacing its edges (see clear()).
+ *        The format has one record per line: "c ..." comments, one "p max <nodes> <arcs>" problem line,
+ *        "n <id> s" and "n <id> t" for the source and sink, and "a <u> <v> <cap>" arcs. Node ids are 1-based in
+ *        the file and 0-based in the solver.
+ *        The file is memory-mapped and parsed by hand in one pass, without streams or a line buffer, and the
+ *        solver is reserved for the arc count of the problem line.
+ * @param path The file to read.
+ * @param solver The solver to fill.
+ * @param s, t Receive the source and sink.
+ * @return false if the file cannot be read or is malformed: no problem line before the first node or arc record,
+ *         a missing source or sink, or an arc whose nodes or capacity are out of range for the solver.
+ * @note Time Complexity: O(file size + V).
+ */
+template <typename Cap, typename Res>
+bool load_dimacs(const string& path, BasicIsap<Cap, Res>& solver, int& s, int& t) {
+    MappedFile file(path);
+    if (!file.data) return false;
+    const char* p = file.data;
+    const char* end = file.data + file.size;
+    long long n = -1;
+    s = t = -1;
+    while (p < end) {
+        const char* line = p;
+        const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!eol) eol = end;
+        p = eol + 1;
+        const char* q = line + 1;
+        long long u, v, cap;
+        switch (*line) {
+        case 'p': {
+            while (q < eol && (*q == ' ' || *q == '\t')) q++;
+            if (eol - q < 3 || strncmp(q, "max", 3) != 0) return false;
+            q += 3;
+            long long m;
+            if (n >= 0 || !parse_number(q, eol, n) || !parse_number(q, eol, m) || n > numeric_limits<int>::max() ||
+                m > numeric_limits<int>::max()) {
+                return false;
+            }
+            solver.clear(n);
+            solver.reserve(m);
+            break;
+        }
+        case 'n': {
+            if (n < 0 || !parse_number(q, eol, u) || u < 1 || u > n) return false;
+            while (q < eol && (*q == ' ' || *q == '\t')) q++;
+            if (q < eol && *q == 's') {
+                s = u - 1;
+            } else if (q < eol && *q == 't') {
+                t = u - 1;
+            } else {
+                return false;
+            }
+            break;
+        }
+        case 'a':
+            if (n < 0 || !parse_number(q, eol, u) || !parse_number(q, eol, v) || !parse_number(q, eol, cap) ||
+                !valid_edge<Res>(n, u - 1, v - 1, cap)) {
+                return false;
+            }
+            solver.add_edge(u - 1, v - 1, (Cap)cap);
+            break;
+        default:
+            // Comments, blank lines and a trailing carriage return of an empty line.
+            break;
+        }
+    }
+    return n >= 0 && s >= 0 && t >= 0;
+}
+
+/**
+ * @brief Writes a graph in the binary format of BinaryGraphHeader, e.g. to convert a DIMACS file once for fast loads.
+ * @return false if the file cannot be written.
+ */
+bool write_binary_graph(const string& path, int n, int s, int t, const vector<int>& from, const vector<int>& to,
+                        const vector<long long>& cap) {
+    FILE* out = fopen(path.c_str(), "wb");
+    if (!out) return false;
+    BinaryGraphHeader header = {{'I', 'S', 'A', 'P', 'B', 'I', 'N', '1'}, n, s, t, 0, from.size()};
+    vector<int32_t> from32(from.begin(), from.end()), to32(to.begin(), to.end());
+    vector<int64_t> cap64(cap.begin(), cap.end());
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+              fwrite(from32.data(), sizeof(int32_t), from32.size(), out) == from32.size() &&
+              fwrite(to32.data(), sizeof(int32_t), to32.size(), out) == to32.size() &&
+              fwrite(cap64.data(), sizeof(int64_t), cap64.size(), out) == cap64.size();
+    return fclose(out) == 0 && ok;
+}
+
+/**
+ * @brief The header of a solver snapshot, followed by the arrays listed at BasicIsap::save_snapshot.
+ *        cap_size, res_size and floating describe Cap and Res, so a snapshot is only loaded by the same instantiation.
+ */
+struct SnapshotHeader {
+    char magic[8];
+    int32_t n;
+    int32_t cap_size;
+    int32_t res_size;
+    int32_t floating;
+    uint64_t m;
+    uint64_t touched;
+    int32_t labels_valid;
+    int32_t label_sink;
+    int32_t cut_sources;
+    int32_t cut_level;
+    int64_t global_relabels;
+    int32_t node_order;
+    int32_t order_root;
+    uint64_t costs;
+    uint64_t lowers;
+    int32_t bounds_violated;
+};
+
+/**
+ * @brief Writes the elements of v as they are in memory, padded with zeros to a multiple of 8 bytes.
+ */
+template <typename T>
+static bool write_array(FILE* out, const vector<T>& v) {
+    static const char zeros[8] = {};
+    // The data of an empty vector may be null, which fwrite must not be given.
+    if (v.empty()) return true;
+    size_t bytes = v.size() * sizeof(T);
+    return fwrite(v.data(), sizeof(T), v.size(), out) == v.size() &&
+           fwrite(zeros, 1, (8 - bytes % 8) % 8, out) == (8 - bytes % 8) % 8;
+}
+
+/**
+ * @brief Copies count elements from a mapped snapshot at p into v and advances p past their padding.
+ *        Returns false if the snapshot ends before them.
+ */
+template <typename T>
+static bool read_array(const char*& p, const char* end, vector<T>& v, uint64_t count) {
+    uint64_t bytes = count * sizeof(T);
+    uint64_t padded = bytes + (8 - bytes % 8) % 8;
+    if (count > (uint64_t)(end - p) / sizeof(T) || padded > (uint64_t)(end - p)) return false;
+    v.resize(count);
+    if (bytes > 0) memcpy(v.data(), p, bytes);
+    p += padded;
+    return true;
+}
+
+/**
+ * @brief Writes the whole state of the solver to path: the graph, the flow and the distance labels, so that
+ *        load_snapshot() continues exactly where this solver is, e.g. augment() resumes with repaired labels
+ *        instead of re-solving.
+ *        After a SnapshotHeader come, each padded to 8 bytes and in the layout of the in-memory arrays:
+ *        edge_from, edge_to, edge_cap, edge_cost and edge_lower (up to m each), edge_arc (m), offset (n + 1), head, rev, res (2m each),
+ *        level (n), gap (n + 2), the touched edges, the sources of the last solve and, under a NodeOrder other than
+ *        Given, node_id (n).
+ *        The current-arc pointers are not saved: every solve restarts them at the first arc of each node.
+ * @note Pending edges are frozen into the CSR arrays first, as on the next solve.
+ * @return false if the file cannot be written.
+ */
+template <typename Cap, typename Res>
+bool BasicIsap<Cap, Res>::save_snapshot(const string& path) {
+    if (!built) build();
+    FILE* out = fopen(path.c_str(), "wb");
+    if (!out) return false;
+    SnapshotHeader header = {{'I', 'S', 'A', 'P', 'S', 'N', 'P', '5'}, n, (int32_t)sizeof(Cap), (int32_t)sizeof(Res),
+                             numeric_limits<Res>::is_integer ? 0 : 1, edge_from.size(), touched.size(),
+                             ws.labels_valid && !ws.phase_labels, ws.label_sink, (int32_t)ws.cut_sources.size(), ws.cut_level, ws.global_relabels,
+                             (int32_t)node_order, order_root, edge_cost.size(), edge_lower.size(), bounds_violated};
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 && write_array(out, edge_from) &&
+              write_array(out, edge_to) && write_array(out, edge_cap) && write_array(out, edge_cost) &&
+              write_array(out, edge_lower) && write_array(out, edge_arc) && write_array(out, offset) && write_array(out, head) && write_array(out, rev) &&
+              write_array(out, ws.res) && write_array(out, ws.level) && write_array(out, ws.gap) &&
+              write_array(out, touched) && write_array(out, ws.cut_sources) && write_array(out, node_id);
+    return fclose(out) == 0 && ok;
+}
+
+/**
+ * @brief Replaces the state of the solver with a snapshot written by save_snapshot() of the same instantiation.
+ *        The file is memory-mapped and each array is copied into place with one memcpy; nothing is rebuilt,
+ *        relabeled or re-solved. The policies and statistics of this solver are kept, except the node order, which
+ *        the arrays are laid out in and is taken from the snapshot. The gap counts are recomputed from the labels.
+ * @return false if the file cannot be read, is not a snapshot, was written for other Cap or Res types, or holds
+ *         inconsistent arrays (an arc, edge or node out of range, reverse arcs that do not pair up, offsets that are
+ *         not monotone); the solver is then unchanged.
+ * @note Time Complexity: O(V + E), bounded by reading the file.
+ */
+template <typename Cap, typename Res>
+bool BasicIsap<Cap, Res>::load_snapshot(const string& path) {
+    MappedFile file(path);
+    SnapshotHeader header;
+    if (file.size < sizeof(header)) return false;
+    memcpy(&header, file.data, sizeof(header));
+    if (memcmp(header.magic, "ISAPSNP5", 8) != 0 || header.n < 0 || header.cap_size != (int32_t)sizeof(Cap) ||
+        header.res_size != (int32_t)sizeof(Res) || header.floating != (numeric_limits<Res>::is_integer ? 0 : 1)) {
+        return false;
+    }
+    const char* p = file.data + sizeof(header);
+    const char* end = file.data + file.size;
+    uint64_t m = header.m;
+    if (m > (uint64_t)numeric_limits<int>::max() / 2) return false;
+    BasicIsap<Cap, Res> next(header.n);
+    if (!read_array(p, end, next.edge_from, m) || !read_array(p, end, next.edge_to, m) ||
+        !read_array(p, end, next.edge_cap, m) || header.costs > m ||
+        !read_array(p, end, next.edge_cost, header.costs) || header.lowers > m ||
+        !read_array(p, end, next.edge_lower, header.lowers) || !read_array(p, end, next.edge_arc, m) ||
+        !read_array(p, end, next.offset, header.n + 1) || !read_array(p, end, next.head, 2 * m) ||
+        !read_array(p, end, next.rev, 2 * m) || !read_array(p, end, next.ws.res, 2 * m) ||
+        !read_array(p, end, next.ws.level, header.n) || !read_array(p, end, next.ws.gap, header.n + 2) ||
+        !read_array(p, end, next.touched, header.touched) ||
+        !read_array(p, end, next.ws.cut_sources, max(header.cut_sources, 0)) ||
+        !read_array(p, end, next.node_id, header.node_order != (int32_t)NodeOrder::Given ? header.n : 0)) {
+        return false;
+    }
+    // Everything a solve indexes with must be in range, so that a corrupt file is rejected here instead of read
+    // out of bounds later: the CSR arrays must pair every arc with a reverse arc back to its tail, and node_id must
+    // be a permutation.
+    int nodes = header.n, arcs = 2 * m;
+    auto node = [&](int v) { return v >= 0 && v < nodes; };
+    vector<int> pos(nodes, -1);
+    for (int v = 0; v < (int)next.node_id.size(); v++) {
+        if (!node(next.node_id[v]) || pos[next.node_id[v]] >= 0) return false;
+        pos[next.node_id[v]] = v;
+    }
+    if (next.offset[0] != 0 || next.offset[nodes] != arcs) return false;
+    for (int u = 0; u < nodes; u++) {
+        if (next.offset[u] > next.offset[u + 1]) return false;
+        for (int a = next.offset[u]; a < next.offset[u + 1]; a++) {
+            int b = next.rev[a];
+            if (!node(next.head[a]) || b < 0 || b >= arcs || next.rev[b] != a || next.head[b] != u) return false;
+        }
+    }
+    for (int id = 0; id < (int)m; id++) {
+        int u = next.edge_from[id], v = next.edge_to[id], a = next.edge_arc[id];
+        if (!node(u) || !node(v) || a < 0 || a >= arcs || next.head[a] != (next.node_id.empty() ? v : pos[v])) {
+            return false;
+        }
+    }
+    // The gap counts are rebuilt from the labels rather than trusted: cut_side() scans them for an empty level.
+    next.ws.gap.assign(nodes + 2, 0);
+    for (int level : next.ws.level) {
+        if (level < 0 || level > nodes) return false;
+        next.ws.gap[level]++;
+    }
+    for (int id : next.touched) {
+        if (id < 0 || id >= (int)m) return false;
+    }
+    for (int v : next.ws.cut_sources) {
+        if (!node(v)) return false;
+    }
+    if (header.label_sink < -1 || header.label_sink >= nodes || header.cut_level < 0 || header.cut_level > nodes ||
+        header.node_order < 0 || header.node_order > (int32_t)NodeOrder::Degree) {
+        return false;
+    }
+    next.demand.assign(next.edge_lower.empty() ? 0 : header.n, 0);
+    for (int id = 0; id < (int)next.edge_lower.size(); id++) {
+        int u = next.edge_from[id], v = next.edge_to[id];
+        next.demand[u] -= next.edge_lower[id];
+        next.demand[v] += next.edge_lower[id];
+    }
+    n = header.n;
+    built = true;
+    edge_from.swap(next.edge_from);
+    edge_to.swap(next.edge_to);
+    edge_cap.swap(next.edge_cap);
+    edge_cost.swap(next.edge_cost);
+    edge_lower.swap(next.edge_lower);
+    bounds_violated = header.bounds_violated;
+    return_edge = -1;
+    demand.swap(next.demand);
+    edge_arc.swap(next.edge_arc);
+    offset.swap(next.offset);
+    head.swap(next.head);
+    rev.swap(next.rev);
+    touched.swap(next.touched);
+    node_order = (NodeOrder)header.node_order;
+    order_root = header.order_root;
+    node_id.swap(next.node_id);
+    node_pos.assign(node_id.size(), 0);
+    for (int v = 0; v < (int)node_id.size(); v++) node_pos[node_id[v]] = v;
+    ws.res.swap(next.ws.res);
+    ws.live_end.clear();
+    ws.level.swap(next.ws.level);
+    ws.gap.swap(next.ws.gap);
+    ws.labels_valid = header.labels_valid;
+    ws.phase_labels = false;
+    ws.label_sink = header.label_sink;
+    ws.cut_sources.swap(next.ws.cut_sources);
+    ws.sinks.assign(header.label_sink >= 0 ? 1 : 0, header.label_sink);
+    ws.cut_level = header.cut_level;
+    ws.global_relabels = header.global_relabels;
+    return true;
+}
+
+template bool BasicIsap<int>::save_snapshot(const string&);
+template bool BasicIsap<long long>::save_snapshot(const string&);
+template bool BasicIsap<double>::save_snapshot(const string&);
+template bool BasicIsap<long long, uint32_t>::save_snapshot(const string&);
+template bool BasicIsap<int>::load_snapshot(const string&);
+template bool BasicIsap<long long>::load_snapshot(const string&);
+template bool BasicIsap<double>::load_snapshot(const string&);
+template bool BasicIsap<long long, uint32_t>::load_snapshot(const string&);
+template bool load_binary_graph(const string&, BasicIsap<int>&, int&, int&);
+template bool load_binary_graph(const string&, BasicIsap<long long>&, int&, int&);
+template bool load_binary_graph(const string&, BasicIsap<double>&, int&, int&);
+template bool load_binary_graph(const string&, BasicIsap<long long, uint32_t>&, int&, int&);
+template bool load_dimacs(const string&, BasicIsap<int>&, int&, int&);
+template bool load_dimacs(const string&, BasicIsap<long long>&, int&, int&);
+template bool load_dimacs(const string&, BasicIsap<double>&, int&, int&);
+template bool load_dimacs(const string&, BasicIsap<long long, uint32_t>&, int&, int&);
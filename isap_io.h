@@ -0,0 +1,35 @@
+#ifndef ISAP_IO_H
+#define ISAP_IO_H
+
+#include "isap.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief The binary edge-list format read by load_binary_graph, all integers little-endian:
+ *        the 8 bytes "ISAPBIN1", then int32 n, s, t and a zero int32, then uint64 m, followed by the arrays
+ *        int32 from[m], int32 to[m] and int64 cap[m]. Node ids are 0-based.
+ *        The header is 32 bytes, so every array is aligned to its element size and the loader reads it in place.
+ */
+struct BinaryGraphHeader {
+    char magic[8];
+    int32_t n;
+    int32_t s;
+    int32_t t;
+    int32_t reserved;
+    uint64_t m;
+};
+
+template <typename Cap, typename Res>
+bool load_binary_graph(const string& path, BasicIsap<Cap, Res>& solver, int& s, int& t);
+
+template <typename Cap, typename Res>
+bool load_dimacs(const string& path, BasicIsap<Cap, Res>& solver, int& s, int& t);
+
+bool write_binary_graph(const string& path, int n, int s, int t, const vector<int>& from, const vector<int>& to,
+                        const vector<long long>& cap);
+
+#endif // ISAP_IO_H
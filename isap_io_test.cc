@@ -0,0 +1,159 @@
+#include "isap_io.h"
+#include <cassert>
+#include <cstdio>
+#include <random>
+
+int main() {
+  // Test case 1: A DIMACS file with comments, the sample graph of isap_sample.cc
+  const char* dimacs = "/tmp/isap_io_test.max";
+  FILE* out = fopen(dimacs, "w");
+  fprintf(out, "c sample graph\np max 6 10\nn 1 s\nn 6 t\n");
+  fprintf(out, "a 1 2 16\na 1 3 13\na 2 3 10\na 3 2 4\na 2 4 12\n");
+  fprintf(out, "c middle comment\n\na 3 5 14\na 4 3 9\na 5 4 7\na 4 6 20\na 5 6 4\n");
+  fclose(out);
+  Isap g1(1);
+  int s, t;
+  assert(load_dimacs(dimacs, g1, s, t));
+  assert(s == 0 && t == 5 && g1.edge_count() == 10);
+  assert(g1.isap(s, t) == 23);
+
+  // Test case 2: Malformed DIMACS files are rejected
+  out = fopen(dimacs, "w");
+  fprintf(out, "p max 3 1\nn 1 s\nn 3 t\na 1 4 5\n");
+  fclose(out);
+  assert(!load_dimacs(dimacs, g1, s, t));
+  out = fopen(dimacs, "w");
+  fprintf(out, "a 1 2 5\np max 3 1\n");
+  fclose(out);
+  assert(!load_dimacs(dimacs, g1, s, t));
+  out = fopen(dimacs, "w");
+  fprintf(out, "p max 2 1\nn 1 s\na 1 2 5\n");
+  fclose(out);
+  assert(!load_dimacs(dimacs, g1, s, t));
+  assert(!load_dimacs("/tmp/isap_io_test.missing", g1, s, t));
+  remove(dimacs);
+
+  // Test case 3: A random graph survives a round trip through the binary format
+  mt19937 rng(3);
+  int n = 200;
+  vector<int> from, to;
+  vector<long long> cap;
+  BasicIsap<long long> direct(n);
+  for (int i = 0; i < 2000; i++) {
+    from.push_back(rng() % n);
+    to.push_back(rng() % n);
+    cap.push_back(rng() % 100000 * 100000LL);
+    direct.add_edge(from.back(), to.back(), cap.back());
+  }
+  const char* binary = "/tmp/isap_io_test.bin";
+  assert(write_binary_graph(binary, n, 0, n - 1, from, to, cap));
+  BasicIsap<long long> loaded(1);
+  assert(load_binary_graph(binary, loaded, s, t));
+  assert(s == 0 && t == n - 1 && loaded.edge_count() == 2000);
+  for (int id = 0; id < 2000; id++) {
+    assert(loaded.get_edge(id).to == to[id] && loaded.get_edge(id).cap == cap[id]);
+  }
+  assert(loaded.isap(s, t) == direct.isap(0, n - 1));
+
+  // Test case 4: Capacities that do not fit the residual type are rejected
+  Isap narrow(1);
+  assert(!load_binary_graph(binary, narrow, s, t));
+
+  // Test case 5: A snapshot restores flow, labels and minimum cut, and augment() resumes from it
+  const char* snapshot = "/tmp/isap_io_test.snap";
+  for (int id = 0; id < 30; id++) loaded.set_capacity(id, cap[id] + 1);
+  assert(loaded.save_snapshot(snapshot));
+  BasicIsap<long long> restored(1);
+  assert(restored.load_snapshot(snapshot));
+  assert(restored.edge_count() == loaded.edge_count());
+  for (int id = 0; id < restored.edge_count(); id++) {
+    assert(restored.get_edge(id).flow == loaded.get_edge(id).flow);
+  }
+  long long more = loaded.augment(s, t);
+  assert(restored.augment(s, t) == more);
+  assert(restored.min_cut_source_side() == loaded.min_cut_source_side());
+
+  // Test case 6: A snapshot is only loaded by the instantiation that wrote it
+  BasicIsap<long long, uint32_t> other(1);
+  assert(!other.load_snapshot(snapshot));
+  // A file in another format, not a missing one: the binary graph is still there
+  FILE* foreign = fopen(binary, "rb");
+  assert(foreign);
+  fclose(foreign);
+  assert(!restored.load_snapshot(binary));
+  assert(restored.edge_count() == loaded.edge_count());
+  remove(binary);
+
+  // Test case 7: A snapshot of a reordered solver keeps its node order and answers in the caller's ids
+  BasicIsap<long long> ordered(n), plain(n);
+  ordered.set_node_order(NodeOrder::ReverseCuthillMcKee, -1);
+  for (int id = 0; id < 2000; id++) {
+    ordered.add_edge(from[id], to[id], cap[id]);
+    plain.add_edge(from[id], to[id], cap[id]);
+  }
+  assert(ordered.isap(0, n - 1) == plain.isap(0, n - 1));
+  assert(ordered.save_snapshot(snapshot));
+  BasicIsap<long long> reloaded(1);
+  assert(reloaded.load_snapshot(snapshot));
+  assert(reloaded.min_cut_source_side() == plain.min_cut_source_side());
+  reloaded.add_edge(0, n - 1, 7);
+  plain.add_edge(0, n - 1, 7);
+  assert(reloaded.augment(0, n - 1) == plain.augment(0, n - 1));
+  assert(reloaded.get_edge(2000).flow == 7);
+
+  // Test case 8: Lower bounds and costs survive a snapshot, and feasible_flow() runs on the loaded solver
+  BasicIsap<long long> bounded(4);
+  bounded.add_bounded_edge(0, 1, 2, 5);
+  bounded.add_bounded_edge(1, 2, 3, 4);
+  bounded.add_edge(1, 3, 6, 9);
+  bounded.add_edge(2, 3, 6);
+  assert(bounded.save_snapshot(snapshot));
+  BasicIsap<long long> bounded_copy(1);
+  assert(bounded_copy.load_snapshot(snapshot));
+  assert(bounded_copy.get_edge(0).cap == 5 && bounded_copy.get_edge(0).flow == 2 && bounded_copy.get_edge(2).cost == 9);
+  assert(bounded_copy.feasible_flow(0, 3) == 3 && bounded.feasible_flow(0, 3) == 3);
+  assert(bounded_copy.get_edge(1).flow == 3 && bounded_copy.get_edge(0).flow == 3);
+
+  // Test case 9: Snapshots with inconsistent arrays are rejected and leave the solver unchanged
+  // Overwrites the int32 at back bytes before the end of the snapshot.
+  auto patch = [&](long back, int32_t value) {
+    FILE* f = fopen(snapshot, "r+b");
+    fseek(f, -back, SEEK_END);
+    fwrite(&value, sizeof(value), 1, f);
+    fclose(f);
+  };
+  assert(ordered.save_snapshot(snapshot));
+  // node_id is the last array, so its last entry is the last int32; repeating node 0's id breaks the permutation.
+  int32_t first_id = 0;
+  FILE* in = fopen(snapshot, "rb");
+  fseek(in, -4 * n, SEEK_END);
+  assert(fread(&first_id, sizeof(first_id), 1, in) == 1);
+  fclose(in);
+  patch(4, first_id);
+  assert(!reloaded.load_snapshot(snapshot));
+  assert(reloaded.edge_count() == 2001);
+  // A solver on 2 nodes with one edge and no solve ends with rev (2 arcs), res (2), level (2) and gap (4), so rev[0]
+  // starts 48 bytes before the end.
+  BasicIsap<long long> tiny(2);
+  tiny.add_edge(0, 1, 5);
+  assert(tiny.save_snapshot(snapshot));
+  patch(48, 100);
+  assert(!bounded_copy.load_snapshot(snapshot));
+  assert(tiny.save_snapshot(snapshot));
+  patch(48, 0);
+  assert(!bounded_copy.load_snapshot(snapshot));
+  assert(bounded_copy.edge_count() == 5 && bounded_copy.get_edge(1).flow == 3);
+  assert(tiny.save_snapshot(snapshot));
+  assert(bounded_copy.load_snapshot(snapshot) && bounded_copy.isap(0, 1) == 5);
+  // Gap counts that disagree with the labels are not trusted: a solver on 2 nodes without edges, solved without a gap
+  // cutoff, ends with gap (4), cut_sources (1, padded to 2) and nothing else, so gap starts 24 bytes before the end.
+  BasicIsap<long long> empty(2);
+  assert(empty.isap(0, 1) == 0);
+  assert(empty.save_snapshot(snapshot));
+  for (int back = 24; back > 8; back -= 4) patch(back, 1);
+  assert(bounded_copy.load_snapshot(snapshot));
+  assert((bounded_copy.min_cut_source_side() == vector<bool>{true, false}));
+  remove(snapshot);
+
+  return 0;
+}
@@ -0,0 +1,38 @@
+#include "isap.h"
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * @brief Computes the maximum flow from s to t with the chosen engine. isap(), push_relabel(),
+ *        highest_label_push_relabel(), unit_capacity_flow() and pruned_isap() can also be called directly; this
+ *        entry point lets callers pick the engine per graph, e.g. by size, without changing how the graph is built.
+ * @note The engines are defined in isap.cc, isap_push_relabel.cc, isap_unit_capacity.cc and isap_prune.cc;
+ *       a program calling max_flow links all of them.
+ * @param threads The number of threads for Engine::ParallelPushRelabel; the other engines run on one.
+ * @return The flow added on top of the current flow.
+ */
+template <typename Cap, typename Res>
+Cap BasicIsap<Cap, Res>::max_flow(int s, int t, Engine engine, int threads) {
+    if (engine == Engine::Auto) {
+        engine = has_unit_capacities() ? Engine::UnitCapacity : Engine::Isap;
+    }
+    if (engine == Engine::ParallelPushRelabel) {
+        return push_relabel(s, t, threads);
+    }
+    if (engine == Engine::UnitCapacity) {
+        return unit_capacity_flow(s, t);
+    }
+    if (engine == Engine::PrunedIsap) {
+        return pruned_isap(s, t);
+    }
+    if (engine == Engine::HighestLabel) {
+        return highest_label_push_relabel(s, t);
+    }
+    return isap(s, t);
+}
+
+template int BasicIsap<int>::max_flow(int, int, Engine, int);
+template long long BasicIsap<long long>::max_flow(int, int, Engine, int);
+template double BasicIsap<double>::max_flow(int, int, Engine, int);
+template long long BasicIsap<long long, uint32_t>::max_flow(int, int, Engine, int);
@@ -0,0 +1,187 @@
+#include "isap.h"
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Computes a flow of value min(limit, maximum flow) from s to t of minimum total cost, on the same CSR arrays
+ *        as the max-flow solvers, with the costs given to add_edge. The flow starts from zero: the current flow is
+ *        reset first, and the minimum-cost flow is left in the solver, so get_edge() reports it edge by edge.
+ * @note Primal-dual successive shortest paths. Node potentials pi keep every reduced cost cost(a) + pi(u) - pi(v) of a
+ *       residual arc (u, v) non-negative, so each phase runs Dijkstra on reduced costs and stops as soon as t is
+ *       settled; adding min(dist(v), dist(t)) to every potential keeps them valid for all nodes, settled or not.
+ *       The shortest s-t paths are then exactly the s-t paths over arcs of reduced cost 0, and the phase augments
+ *       along all of them at once with the ISAP loop restricted to those arcs: distance labels from a BFS to t,
+ *       current arcs, relabels and the gap heuristic, on the workspace arrays isap() uses.
+ * @note Negative costs are allowed if no cycle of negative total cost is reachable from s; the initial potentials then
+ *       come from a queue-based Bellman-Ford. With a negative cycle the result is a zero flow.
+ * @note For floating-point types, arcs with a reduced cost up to 1e-9 count as zero.
+ * @note Time Complexity: O(F * (E + V log V)) for F the number of phases, at most the number of distinct shortest
+ *       path costs; each phase is one Dijkstra plus an ISAP max flow on the zero-cost arcs.
+ * @param s The source node.
+ * @param t The sink node.
+ * @param limit The largest flow value to route.
+ * @return The flow value and its total cost.
+ */
+template <typename Cap, typename Res>
+pair<Cap, CostType<Cap>> BasicIsap<Cap, Res>::min_cost_flow(int s, int t, Cap limit) {
+    typedef CostType<Cap> Cost;
+    if (!built) build();
+    s = inner(s);
+    t = inner(t);
+    reset_flows();
+    ws.cut_sources.assign(1, s);
+    ws.cut_level = 0;
+    touched.clear();
+    if (s == t) return {0, 0};
+    int arcs = head.size();
+    vector<Cost> cost(arcs, 0);
+    bool negative = false;
+    for (int id = 0; id < (int)edge_cost.size(); id++) {
+        cost[edge_arc[id]] = edge_cost[id];
+        cost[rev[edge_arc[id]]] = -edge_cost[id];
+        negative |= edge_cost[id] < 0 && edge_cap[id] > 0;
+    }
+    const Cost unreached = numeric_limits<Cost>::max() / 4;
+    const Cost tight = numeric_limits<Cost>::is_integer ? 0 : (Cost)1e-9;
+    vector<Cost> pi(n, 0), dist(n);
+    if (negative) {
+        // Shortest distances from s as potentials; a node entering the queue n times lies on a negative cycle.
+        fill(dist.begin(), dist.end(), unreached);
+        vector<int> rounds(n, 0);
+        vector<char> queued(n, 0);
+        queue<int> q;
+        dist[s] = 0;
+        q.push(s);
+        queued[s] = 1;
+        while (!q.empty()) {
+            int u = q.front();
+            q.pop();
+            queued[u] = 0;
+            for (int a = offset[u]; a < offset[u + 1]; a++) {
+                int v = head[a];
+                if (ws.res[a] > 0 && dist[u] + cost[a] < dist[v]) {
+                    dist[v] = dist[u] + cost[a];
+                    if (!queued[v]) {
+                        if (++rounds[v] >= n) return {0, 0};
+                        queued[v] = 1;
+                        q.push(v);
+                    }
+                }
+            }
+        }
+        for (int v = 0; v < n; v++) {
+            if (dist[v] < unreached) pi[v] = dist[v];
+        }
+    }
+
+    vector<int>& level = ws.level;
+    vector<int>& gap = ws.gap;
+    vector<int>& cur = ws.cur;
+    vector<int>& path = ws.path;
+    auto reduced = [&](int a, int u, int v) { return cost[a] + pi[u] - pi[v]; };
+    vector<char> settled(n);
+    priority_queue<pair<Cost, int>, vector<pair<Cost, int>>, greater<pair<Cost, int>>> heap;
+    Cap flow = 0;
+    while (flow < limit) {
+        fill(dist.begin(), dist.end(), unreached);
+        fill(settled.begin(), settled.end(), 0);
+        heap = decltype(heap)();
+        dist[s] = 0;
+        heap.push({0, s});
+        while (!heap.empty()) {
+            int u = heap.top().second;
+            heap.pop();
+            if (settled[u]) continue;
+            settled[u] = 1;
+            if (u == t) break;
+            for (int a = offset[u]; a < offset[u + 1]; a++) {
+                int v = head[a];
+                Cost d = dist[u] + reduced(a, u, v);
+                if (ws.res[a] > 0 && d < dist[v]) {
+                    dist[v] = d;
+                    heap.push({d, v});
+                }
+            }
+        }
+        if (!settled[t]) break;
+        for (int v = 0; v < n; v++) {
+            pi[v] += min(dist[v], dist[t]);
+        }
+
+        // Distance labels to t over the residual arcs of reduced cost 0.
+        fill(level.begin(), level.end(), n);
+        fill(gap.begin(), gap.end(), 0);
+        queue<int> q;
+        q.push(t);
+        level[t] = 0;
+        gap[0] = 1;
+        while (!q.empty()) {
+            int u = q.front();
+            q.pop();
+            for (int a = offset[u]; a < offset[u + 1]; a++) {
+                int v = head[a], b = rev[a];
+                if (level[v] == n && ws.res[b] > 0 && reduced(b, v, u) <= tight) {
+                    level[v] = level[u] + 1;
+                    gap[level[v]]++;
+                    q.push(v);
+                }
+            }
+        }
+        cur.assign(offset.begin(), offset.end() - 1);
+        path.clear();
+        int u = s;
+        while (level[s] < n && flow < limit) {
+            if (u == t) {
+                Cap f = limit - flow;
+                for (int x : path) f = min(f, (Cap)ws.res[cur[x]]);
+                for (int x : path) {
+                    ws.res[cur[x]] -= f;
+                    ws.res[rev[cur[x]]] += f;
+                }
+                flow += f;
+                path.clear();
+                u = s;
+                continue;
+            }
+            int a = cur[u];
+            while (a < offset[u + 1] &&
+                   !(ws.res[a] > 0 && level[head[a]] == level[u] - 1 && reduced(a, u, head[a]) <= tight)) {
+                a++;
+            }
+            cur[u] = a;
+            if (a < offset[u + 1]) {
+                path.push_back(u);
+                u = head[a];
+                continue;
+            }
+            int lowest = n - 1;
+            for (int b = offset[u]; b < offset[u + 1]; b++) {
+                if (ws.res[b] > 0 && reduced(b, u, head[b]) <= tight) lowest = min(lowest, level[head[b]]);
+            }
+            if (gap[level[u]] == 1) break;
+            gap[level[u]]--;
+            gap[level[u] = lowest + 1]++;
+            cur[u] = offset[u];
+            if (!path.empty()) {
+                u = path.back();
+                path.pop_back();
+            }
+        }
+    }
+    ws.labels_valid = false;
+
+    Cost total = 0;
+    for (int id = 0; id < (int)edge_cost.size(); id++) {
+        total += edge_cost[id] * (Cost)((Cap)edge_cap[id] - ws.res[edge_arc[id]]);
+    }
+    return {flow, total};
+}
+
+template pair<int, CostType<int>> BasicIsap<int>::min_cost_flow(int, int, int);
+template pair<long long, CostType<long long>> BasicIsap<long long>::min_cost_flow(int, int, long long);
+template pair<double, CostType<double>> BasicIsap<double>::min_cost_flow(int, int, double);
+template pair<long long, CostType<long long>> BasicIsap<long long, uint32_t>::min_cost_flow(int, int, long long);
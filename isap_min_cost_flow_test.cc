@@ -0,0 +1,167 @@
+#include "isap.h"
+#include <cassert>
+#include <cmath>
+#include <random>
+
+struct RefEdge {
+  int u, v;
+  long long cap, cost;
+};
+
+/**
+ * @brief Successive shortest paths with Bellman-Ford, one path per round: the reference for min_cost_flow().
+ *        Requires no negative cycle in the graph.
+ */
+static pair<long long, long long> reference_min_cost_flow(int n, const vector<RefEdge>& edges, int s, int t,
+                                                          long long limit) {
+  struct Arc {
+    int to;
+    long long res, cost;
+  };
+  vector<Arc> arcs;
+  vector<vector<int>> out(n);
+  for (const RefEdge& e : edges) {
+    out[e.u].push_back(arcs.size());
+    arcs.push_back({e.v, e.cap, e.cost});
+    out[e.v].push_back(arcs.size());
+    arcs.push_back({e.u, 0, -e.cost});
+  }
+  const long long unreached = numeric_limits<long long>::max() / 4;
+  long long flow = 0, cost = 0;
+  while (flow < limit) {
+    vector<long long> dist(n, unreached);
+    vector<int> via(n, -1);
+    dist[s] = 0;
+    for (int round = 0; round < n; round++) {
+      for (int u = 0; u < n; u++) {
+        if (dist[u] == unreached) continue;
+        for (int a : out[u]) {
+          if (arcs[a].res > 0 && dist[u] + arcs[a].cost < dist[arcs[a].to]) {
+            dist[arcs[a].to] = dist[u] + arcs[a].cost;
+            via[arcs[a].to] = a;
+          }
+        }
+      }
+    }
+    if (dist[t] == unreached) break;
+    long long f = limit - flow;
+    for (int v = t; v != s; v = arcs[via[v] ^ 1].to) f = min(f, arcs[via[v]].res);
+    for (int v = t; v != s; v = arcs[via[v] ^ 1].to) {
+      arcs[via[v]].res -= f;
+      arcs[via[v] ^ 1].res += f;
+    }
+    flow += f;
+    cost += f * dist[t];
+  }
+  return {flow, cost};
+}
+
+/**
+ * @brief Checks that the flow in g respects the capacities, is conserved at every node but s and t, and has the given
+ *        value and cost. edges lists the tails of g's edges, in id order.
+ */
+template <typename Solver>
+static void check_flow(const Solver& g, int n, const vector<RefEdge>& edges, int s, int t, long long value,
+                       long long cost) {
+  vector<long long> balance(n, 0);
+  long long total = 0;
+  for (int id = 0; id < g.edge_count(); id++) {
+    auto e = g.get_edge(id);
+    assert(e.flow >= 0 && e.flow <= e.cap && e.cost == edges[id].cost);
+    balance[edges[id].u] -= e.flow;
+    balance[e.to] += e.flow;
+    total += e.cost * e.flow;
+  }
+  for (int v = 0; v < n; v++) {
+    if (v != s && v != t) assert(balance[v] == 0);
+  }
+  assert(balance[t] == value && total == cost);
+}
+
+int main() {
+  // Test case 1: The cheaper of two routes fills first, and the limit stops the flow part way
+  Isap g1(4);
+  g1.add_edge(0, 1, 2, 1);
+  g1.add_edge(1, 3, 2, 1);
+  g1.add_edge(0, 2, 3, 5);
+  g1.add_edge(2, 3, 3, 0);
+  g1.add_edge(1, 2, 1, 1);
+  pair<int, long long> r1 = g1.min_cost_flow(0, 3);
+  assert(r1.first == 5 && r1.second == 2 * 2 + 3 * 5);
+  r1 = g1.min_cost_flow(0, 3, 3);
+  assert(r1.first == 3 && r1.second == 2 * 2 + 5);
+  assert(g1.get_edge(0).flow == 2 && g1.get_edge(2).flow == 1);
+  r1 = g1.min_cost_flow(0, 3, 2);
+  assert(r1.first == 2 && r1.second == 4 && g1.get_edge(2).flow == 0);
+
+  // Test case 2: Random graphs agree with the reference, under every node order and with arc partitioning
+  mt19937 rng(27);
+  for (int round = 0; round < 200; round++) {
+    int n = 2 + rng() % 25, m = rng() % 80;
+    vector<RefEdge> edges;
+    BasicIsap<long long> g(n);
+    if (round % 4 == 1) g.set_node_order(NodeOrder::Bfs, n - 1);
+    if (round % 4 == 2) g.set_node_order(NodeOrder::Degree);
+    if (round % 4 == 3) g.set_arc_partitioning(true);
+    for (int i = 0; i < m; i++) {
+      RefEdge e = {(int)(rng() % n), (int)(rng() % n), (long long)(rng() % 10), (long long)(rng() % 20)};
+      edges.push_back(e);
+      g.add_edge(e.u, e.v, e.cap, e.cost);
+    }
+    long long limit = round % 3 ? 1000 : rng() % 12;
+    pair<long long, long long> expected = reference_min_cost_flow(n, edges, 0, n - 1, limit);
+    pair<long long, long long> got = g.min_cost_flow(0, n - 1, limit);
+    assert(got == expected);
+    check_flow(g, n, edges, 0, n - 1, got.first, got.second);
+    // The same graph then serves the max-flow solvers, continuing from the flow left behind.
+    long long more = g.isap(0, n - 1);
+    if (limit == 1000) assert(more == 0);
+    g.reset_flows();
+    assert(g.isap(0, n - 1) == got.first + more);
+  }
+
+  // Test case 3: Negative costs without negative cycles: edges with u < v may cost less than 0
+  for (int round = 0; round < 100; round++) {
+    int n = 3 + rng() % 20, m = rng() % 70;
+    vector<RefEdge> edges;
+    Isap g(n);
+    for (int i = 0; i < m; i++) {
+      int u = rng() % n, v = rng() % n;
+      if (u == v) continue;
+      long long cost = u < v ? (long long)(rng() % 30) - 15 : (long long)(rng() % 10);
+      if (u > v) cost += 15 * (u - v);
+      RefEdge e = {u, v, (long long)(rng() % 8), cost};
+      edges.push_back(e);
+      g.add_edge(e.u, e.v, (int)e.cap, e.cost);
+    }
+    pair<long long, long long> expected = reference_min_cost_flow(n, edges, 0, n - 1, 1000);
+    pair<int, long long> got = g.min_cost_flow(0, n - 1);
+    assert(got.first == expected.first && got.second == expected.second);
+    check_flow(g, n, edges, 0, n - 1, got.first, got.second);
+  }
+
+  // Test case 4: A reachable negative cycle yields no flow
+  Isap g4(4);
+  g4.add_edge(0, 1, 1, 1);
+  g4.add_edge(1, 2, 1, -5);
+  g4.add_edge(2, 1, 1, 1);
+  g4.add_edge(2, 3, 1, 1);
+  assert(g4.min_cost_flow(0, 3) == make_pair(0, 0LL));
+
+  // Test case 5: Floating-point capacities and costs; edges without a cost cost 0
+  BasicIsap<double> g5(4);
+  g5.add_edge(0, 1, 1.5, 0.25);
+  g5.add_edge(0, 2, 2.0, 0.5);
+  g5.add_edge(1, 3, 2.0, 0.25);
+  g5.add_edge(2, 3, 1.0);
+  g5.add_edge(2, 1, 1.0, 0.1);
+  pair<double, double> r5 = g5.min_cost_flow(0, 3);
+  assert(fabs(r5.first - 3.0) < 1e-9);
+  assert(fabs(r5.second - (1.5 * 0.5 + 1.0 * 0.5 + 0.5 * (0.5 + 0.1 + 0.25))) < 1e-9);
+  assert(g5.get_edge(3).cost == 0);
+
+  // Test case 6: Source equals sink
+  assert(g1.min_cost_flow(2, 2) == make_pair(0, 0LL));
+
+  return 0;
+}
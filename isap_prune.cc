@@ -0,0 +1,175 @@
+#include "isap.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Marks the nodes reachable from start in the residual graph, or, with backward set, the nodes that can reach it.
+ */
+template <typename Res>
+static vector<char> residual_reach(int n, int start, bool backward, const vector<int>& offset, const vector<int>& head,
+                                   const vector<int>& rev, const vector<Res>& res) {
+    vector<char> seen(n, 0);
+    vector<int> q(1, start);
+    seen[start] = 1;
+    for (int i = 0; i < (int)q.size(); i++) {
+        int u = q[i];
+        for (int a = offset[u]; a < offset[u + 1]; a++) {
+            int v = head[a];
+            if (!seen[v] && (backward ? res[rev[a]] : res[a]) > 0) {
+                seen[v] = 1;
+                q.push_back(v);
+            }
+        }
+    }
+    return seen;
+}
+
+/**
+ * @brief Computes the maximum flow from s to t like isap(), after compacting the residual graph, and maps the
+ *        flow back onto the original edges.
+ *
+ * The compaction removes work the ISAP loop would otherwise spend on nodes and arcs that cannot carry flow:
+ *   1. Only nodes both reachable from s and able to reach t in the residual graph are kept. The others would still be
+ *      relabeled and scanned, and would count in gap and in the level[s] < n bound.
+ *   2. All residual arcs from u to v, forward arcs of edges and reverse arcs of flow alike, are merged into one arc
+ *      group whose capacity is the sum of their residuals.
+ *   3. A node other than s and t with a single group in and a single group out only relays flow, so chains of such
+ *      nodes are contracted into one arc with the smallest capacity along them. Contracted arcs between the same two
+ *      nodes are merged again.
+ * isap() then runs on the compacted graph, with node ids renumbered. The flow of each compacted arc is split over its
+ * chains, every chain pushes its share along its groups, and every group over its arcs. Each arc of the original
+ * graph belongs to at most one group and each group to one chain, so the result is a flow on the original graph.
+ *
+ * @note Like after push_relabel(), min_cut_source_side() and min_cut_edges() then read the minimum cut from the
+ *       original residual graph, in original ids, and augment() relabels from scratch.
+ * @note Nodes that cannot reach t already get label n from bfs() and are never entered by isap(), so on graphs
+ *       where ISAP needs few relabels the passes of the compaction cost more than they save. It pays off on
+ *       relabel-heavy instances with many dead nodes, chains or parallel arcs.
+ * @note Time Complexity: O(V + E) for the compaction and the mapping, plus isap() on the compacted graph.
+ * @param s The source node.
+ * @param t The sink node.
+ * @return The flow added on top of the current flow.
+ */
+template <typename Cap, typename Res>
+Cap BasicIsap<Cap, Res>::pruned_isap(int s, int t) {
+    if (!built) build();
+    s = inner(s);
+    t = inner(t);
+    ws.labels_valid = false;
+    ws.cut_sources.assign(1, s);
+    ws.cut_level = 0;
+    touched.clear();
+    ws.live_end.clear();
+    if (s == t) return 0;
+    vector<char> alive = residual_reach(n, s, false, offset, head, rev, ws.res);
+    if (!alive[t]) return 0;
+    vector<char> to_sink = residual_reach(n, t, true, offset, head, rev, ws.res);
+    for (int v = 0; v < n; v++) alive[v] &= to_sink[v];
+
+    // Arc groups, numbered in order of their tails; the arcs of group g are first_arc[g], next_arc[...], ...
+    vector<int> group_tail, group_head, first_arc;
+    vector<Cap> group_cap;
+    vector<int> next_arc(head.size(), -1);
+    vector<int> group_of(n, -1), in_groups(n, 0), out_groups(n, 0), out_group(n, -1);
+    for (int u = 0; u < n; u++) {
+        if (!alive[u]) continue;
+        int first = group_tail.size();
+        for (int a = offset[u]; a < offset[u + 1]; a++) {
+            int v = head[a];
+            if (v == u || !alive[v] || ws.res[a] <= 0) continue;
+            int& g = group_of[v];
+            if (g < first) {
+                g = group_tail.size();
+                group_tail.push_back(u);
+                group_head.push_back(v);
+                group_cap.push_back(0);
+                first_arc.push_back(-1);
+                in_groups[v]++;
+                out_groups[u]++;
+                out_group[u] = g;
+            }
+            group_cap[g] += ws.res[a];
+            next_arc[a] = first_arc[g];
+            first_arc[g] = a;
+        }
+    }
+    auto relay = [&](int v) { return v != s && v != t && in_groups[v] == 1 && out_groups[v] == 1; };
+
+    // Chains: the groups from a kept node through relay nodes to the next kept node, stored back to back.
+    vector<int> chain_groups, chain_start, chain_tail, chain_head;
+    vector<Cap> chain_cap;
+    for (int g = 0; g < (int)group_tail.size(); g++) {
+        if (relay(group_tail[g])) continue;
+        chain_start.push_back(chain_groups.size());
+        chain_tail.push_back(group_tail[g]);
+        Cap cap = group_cap[g];
+        int last = g;
+        chain_groups.push_back(g);
+        while (relay(group_head[last])) {
+            last = out_group[group_head[last]];
+            cap = min(cap, group_cap[last]);
+            chain_groups.push_back(last);
+        }
+        chain_head.push_back(group_head[last]);
+        chain_cap.push_back(cap);
+    }
+    chain_start.push_back(chain_groups.size());
+
+    // Renumber the kept nodes and merge chains between the same two of them into one edge of the compacted graph.
+    vector<int> id(n, -1);
+    int k = 0;
+    for (int v = 0; v < n; v++) {
+        if (alive[v] && !relay(v)) id[v] = k++;
+    }
+    BasicIsap<Cap> compact(k, chain_tail.size());
+    vector<int> edge_of(n, -1), chain_edge(chain_tail.size(), -1), edge_tail;
+    vector<Cap> edge_total;
+    for (int c = 0; c < (int)chain_tail.size(); c++) {
+        int u = chain_tail[c], v = chain_head[c];
+        if (u == v) continue;
+        if (edge_of[v] < 0 || edge_tail[edge_of[v]] != u) {
+            edge_of[v] = edge_tail.size();
+            edge_tail.push_back(u);
+            edge_total.push_back(0);
+        }
+        chain_edge[c] = edge_of[v];
+        edge_total[edge_of[v]] += chain_cap[c];
+    }
+    for (int c = 0, next = 0; c < (int)chain_tail.size(); c++) {
+        if (chain_edge[c] == next) {
+            compact.add_edge(id[chain_tail[c]], id[chain_head[c]], edge_total[next]);
+            next++;
+        }
+    }
+    Cap flow = compact.isap(id[s], id[t]);
+
+    // Map the flow back: compacted edge -> chains -> groups -> arcs.
+    vector<Cap> left(edge_tail.size());
+    for (int e = 0; e < (int)edge_tail.size(); e++) {
+        left[e] = compact.get_edge(e).flow;
+    }
+    for (int c = 0; c < (int)chain_tail.size(); c++) {
+        int e = chain_edge[c];
+        if (e < 0 || left[e] <= 0) continue;
+        Cap d = min(left[e], chain_cap[c]);
+        left[e] -= d;
+        for (int i = chain_start[c]; i < chain_start[c + 1]; i++) {
+            Cap rest = d;
+            for (int a = first_arc[chain_groups[i]]; a >= 0 && rest > 0; a = next_arc[a]) {
+                Cap push = min(rest, (Cap)ws.res[a]);
+                ws.res[a] -= push;
+                ws.res[rev[a]] += push;
+                rest -= push;
+            }
+        }
+    }
+    return flow;
+}
+
+template int BasicIsap<int>::pruned_isap(int, int);
+template long long BasicIsap<long long>::pruned_isap(int, int);
+template double BasicIsap<double>::pruned_isap(int, int);
+template long long BasicIsap<long long, uint32_t>::pruned_isap(int, int);
@@ -0,0 +1,64 @@
+#include "isap.h"
+#include <cassert>
+#include <random>
+
+/**
+ * @brief Checks that the flow in g respects the capacities, and that its minimum cut separates s from t and matches value.
+ */
+template <typename Solver>
+static void check_flow(const Solver& g, int n, int s, int t, long long value) {
+  for (int id = 0; id < g.edge_count(); id++) {
+    auto e = g.get_edge(id);
+    assert(e.flow >= 0 && e.flow <= e.cap);
+  }
+  long long cut = 0;
+  for (int id : g.min_cut_edges()) cut += g.get_edge(id).cap;
+  vector<bool> side = g.min_cut_source_side();
+  assert((int)side.size() == n && side[s] && !side[t] && cut == value);
+}
+
+int main() {
+  // Test case 1: Dead nodes, a chain, parallel arcs and a dead-end branch
+  Isap g1(9);
+  g1.add_edge(0, 1, 5);
+  g1.add_edge(0, 1, 4);
+  g1.add_edge(1, 2, 7);
+  g1.add_edge(2, 3, 6);
+  g1.add_edge(3, 8, 10);
+  g1.add_edge(0, 4, 3);
+  g1.add_edge(4, 5, 3);
+  g1.add_edge(6, 8, 9);
+  g1.add_edge(7, 1, 2);
+  g1.add_edge(1, 8, 1);
+  assert(g1.pruned_isap(0, 8) == 7);
+  assert(g1.get_edge(0).flow + g1.get_edge(1).flow == 7);
+  assert(g1.get_edge(2).flow == 6 && g1.get_edge(3).flow == 6 && g1.get_edge(9).flow == 1);
+  assert(g1.get_edge(5).flow == 0 && g1.get_edge(7).flow == 0);
+  check_flow(g1, 9, 0, 8, 7);
+
+  // Test case 2: Random sparse graphs agree with isap(), also when continuing from a partial flow
+  mt19937 rng(2);
+  for (int round = 0; round < 100; round++) {
+    int n = 40;
+    BasicIsap<long long> pruned(n), seq(n);
+    for (int i = 0; i < 70; i++) {
+      int u = rng() % n, v = rng() % n;
+      long long cap = rng() % 20;
+      pruned.add_edge(u, v, cap);
+      seq.add_edge(u, v, cap);
+    }
+    long long expected = seq.isap(0, n - 1);
+    if (round % 2) {
+      long long first = pruned.isap(0, n - 1);
+      pruned.add_edge(0, n - 1, 3);
+      seq.add_edge(0, n - 1, 3);
+      expected = first + 3;
+      assert(pruned.pruned_isap(0, n - 1) == 3);
+    } else {
+      assert(pruned.max_flow(0, n - 1, Engine::PrunedIsap) == expected);
+    }
+    check_flow(pruned, n, 0, n - 1, expected);
+  }
+
+  return 0;
+}
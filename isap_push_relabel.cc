@@ -0,0 +1,387 @@
+#include "isap.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief A reusable barrier for the rounds of push_relabel_phase: wait() returns once all count threads called it.
+ */
+class PushRelabelBarrier {
+public:
+    explicit PushRelabelBarrier(int count) : count(count) {}
+
+    void wait() {
+        unique_lock<mutex> lock(m);
+        long long generation = this->generation;
+        if (++waiting == count) {
+            waiting = 0;
+            this->generation++;
+            cv.notify_all();
+        } else {
+            cv.wait(lock, [&] { return this->generation != generation; });
+        }
+    }
+
+private:
+    mutex m;
+    condition_variable cv;
+    int count;
+    int waiting = 0;
+    long long generation = 0;
+};
+
+/**
+ * @brief Adds delta to an atomic excess. A compare-and-swap loop, since atomic<double> has no fetch_add before C++20.
+ */
+template <typename Cap>
+static void add_excess(atomic<Cap>& excess, Cap delta) {
+    Cap old = excess.load(memory_order_relaxed);
+    while (!excess.compare_exchange_weak(old, old + delta, memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Computes the distance of every node to target in the residual graph (a global relabel), by BFS over
+ *        reverse arcs. blocked and the nodes that cannot reach target get label n.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::push_relabel_labels(vector<int>& label, int target, int blocked) const {
+    label.assign(n, n);
+    label[target] = 0;
+    queue<int> q;
+    q.push(target);
+    while (!q.empty()) {
+        int u = q.front();
+        q.pop();
+        for (int a = offset[u]; a < offset[u + 1]; a++) {
+            int v = head[a];
+            if (label[v] == n && v != blocked && ws.res[rev[a]] > 0) {
+                label[v] = label[u] + 1;
+                q.push(v);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Pushes the excess of every node other than target and blocked towards target, until no node with a label
+ *        below n has excess left.
+ *
+ * The nodes with excess are processed in synchronous rounds, all threads working on the same round:
+ *   1. Push: each active node v pushes its excess over its admissible arcs (label[v] = label[w] + 1). Labels are
+ *      fixed during this step, so the reverse arc w -> v of an arc v pushes on is not admissible for w, and only v
+ *      touches the residuals of both. The excess of w is the only shared value and is updated atomically.
+ *      Nodes that receive excess are queued for the next round once, through an atomic flag.
+ *   2. Relabel: each node that still has excess after scanning all its arcs computes its new label from the labels
+ *      of the round, min(label[w] + 1) over its residual arcs. New labels are only written after every node has
+ *      computed its own, and since labels never decrease, the new labels stay valid.
+ * After the relabels have scanned 6n + m arcs, the labels are recomputed by a global relabel.
+ */
+template <typename Cap, typename Res>
+void BasicIsap<Cap, Res>::push_relabel_phase(atomic<Cap>* excess, vector<int>& label, int target, int blocked,
+                                             int threads) {
+    const int chunk = 64;
+    const long long work_limit = 6LL * n + (long long)head.size();
+    push_relabel_labels(label, target, blocked);
+    vector<int> active;
+    for (int v = 0; v < n; v++) {
+        if (v != target && v != blocked && label[v] < n && excess[v].load(memory_order_relaxed) > 0) {
+            active.push_back(v);
+        }
+    }
+    if (active.empty()) return;
+
+    unique_ptr<atomic<char>[]> queued(new atomic<char>[n]);
+    for (int v = 0; v < n; v++) queued[v].store(0, memory_order_relaxed);
+    vector<vector<int>> next(threads), relabels(threads), new_labels(threads);
+    vector<long long> work(threads, 0);
+    long long total_work = 0;
+    atomic<int> cursor(0);
+    bool done = false;
+    PushRelabelBarrier barrier(threads);
+
+    auto discharge = [&](int v, int id) {
+        Cap e = excess[v].load(memory_order_relaxed);
+        if (e <= 0) return;
+        Cap left = e;
+        int dv = label[v];
+        for (int a = offset[v]; a < offset[v + 1] && left > 0; a++) {
+            int w = head[a];
+            if (label[w] + 1 != dv || ws.res[a] <= 0) continue;
+            Cap delta = min(left, (Cap)ws.res[a]);
+            ws.res[a] -= delta;
+            ws.res[rev[a]] += delta;
+            left -= delta;
+            add_excess(excess[w], delta);
+            if (w != target && w != blocked && !queued[w].exchange(1, memory_order_relaxed)) {
+                next[id].push_back(w);
+            }
+        }
+        add_excess(excess[v], left - e);
+        if (left > 0) relabels[id].push_back(v);
+    };
+
+    auto worker = [&](int id) {
+        while (true) {
+            barrier.wait();
+            if (done) return;
+            int size = active.size();
+            for (int i = cursor.fetch_add(chunk); i < size; i = cursor.fetch_add(chunk)) {
+                for (int k = i; k < min(size, i + chunk); k++) {
+                    discharge(active[k], id);
+                }
+            }
+            barrier.wait();
+            new_labels[id].clear();
+            for (int v : relabels[id]) {
+                int best = n;
+                for (int a = offset[v]; a < offset[v + 1]; a++) {
+                    if (ws.res[a] > 0) best = min(best, label[head[a]] + 1);
+                }
+                work[id] += offset[v + 1] - offset[v];
+                new_labels[id].push_back(best);
+            }
+            barrier.wait();
+            for (int k = 0; k < (int)relabels[id].size(); k++) {
+                int v = relabels[id][k];
+                label[v] = new_labels[id][k];
+                if (label[v] < n && !queued[v].exchange(1, memory_order_relaxed)) next[id].push_back(v);
+            }
+            relabels[id].clear();
+            barrier.wait();
+            if (id == 0) {
+                active.clear();
+                for (int t = 0; t < threads; t++) {
+                    active.insert(active.end(), next[t].begin(), next[t].end());
+                    next[t].clear();
+                    total_work += work[t];
+                    work[t] = 0;
+                }
+                for (int v : active) queued[v].store(0, memory_order_relaxed);
+                if (total_work >= work_limit) {
+                    total_work = 0;
+                    push_relabel_labels(label, target, blocked);
+                }
+                active.erase(remove_if(active.begin(), active.end(), [&](int v) { return label[v] >= n; }),
+                             active.end());
+                cursor.store(0);
+                done = active.empty();
+            }
+        }
+    };
+
+    vector<thread> pool;
+    for (int id = 1; id < threads; id++) {
+        pool.emplace_back(worker, id);
+    }
+    worker(0);
+    for (auto& th : pool) {
+        th.join();
+    }
+}
+
+/**
+ * @brief Computes the maximum flow from s to t with a synchronous parallel push-relabel on threads threads,
+ *        starting from the current flow like isap(). The graph is read from the same CSR arrays, and the flow is left
+ *        in them, so get_edge(), min_cut_source_side() and augment() work afterwards as after isap().
+ * @note The first phase saturates the arcs leaving s and moves excess towards t until no excess can reach t, which
+ *       gives a maximum preflow. The second phase runs the same rounds towards s to return the excess that is left,
+ *       turning the preflow into a flow. See push_relabel_phase for one phase.
+ * @note Time Complexity: O(V^2 E) work in the worst case, split over the threads within each round.
+ * @param s The source node.
+ * @param t The sink node.
+ * @param threads The number of threads, including the calling one.
+ * @return The flow added on top of the current flow.
+ */
+template <typename Cap, typename Res>
+Cap BasicIsap<Cap, Res>::push_relabel(int s, int t, int threads) {
+    if (!built) build();
+    s = inner(s);
+    t = inner(t);
+    threads = max(1, threads);
+    ws.labels_valid = false;
+    ws.cut_sources.assign(1, s);
+    ws.cut_level = 0;
+    touched.clear();
+    ws.live_end.clear();
+    if (s == t) return 0;
+    unique_ptr<atomic<Cap>[]> excess(new atomic<Cap>[n]);
+    for (int v = 0; v < n; v++) excess[v].store(0, memory_order_relaxed);
+    for (int a = offset[s]; a < offset[s + 1]; a++) {
+        if (head[a] == s || ws.res[a] <= 0) continue;
+        Cap delta = ws.res[a];
+        ws.res[a] = 0;
+        ws.res[rev[a]] += delta;
+        excess[head[a]].store(excess[head[a]].load(memory_order_relaxed) + delta, memory_order_relaxed);
+    }
+    vector<int> label;
+    push_relabel_phase(excess.get(), label, t, s, threads);
+    Cap flow = excess[t].load();
+    push_relabel_phase(excess.get(), label, s, t, threads);
+    return flow;
+}
+
+/**
+ * @brief Computes the maximum flow from s to t with a sequential highest-label push-relabel, starting from the current
+ *        flow like isap(). Instead of following one augmenting path at a time from s, it always discharges an active
+ *        node with the highest label, so a high-degree node pushes all of its excess in one scan of its arcs.
+ *        This suits dense graphs, where the ISAP loop walks through the same high-degree nodes path after path.
+ * @note The labels are level and their counts are gap, as in the ISAP loop. Active nodes are kept in one bucket per
+ *       label, and all nodes below n in a doubly linked list per label, so that when a relabel empties a label
+ *       (gap[k] drops to 0), every node above it is lifted to n at once. Labels are recomputed by bfs() at the
+ *       start and after every 6n + m arcs of relabel work. The excess that cannot reach t is then returned to s by
+ *       the second phase of push_relabel() on one thread.
+ * @note Time Complexity: O(V^2 E^(1/2)).
+ * @param s The source node.
+ * @param t The sink node.
+ * @return The flow added on top of the current flow.
+ */
+template <typename Cap, typename Res>
+Cap BasicIsap<Cap, Res>::highest_label_push_relabel(int s, int t) {
+    if (!built) build();
+    s = inner(s);
+    t = inner(t);
+    ws.cut_sources.assign(1, s);
+    ws.cut_level = 0;
+    touched.clear();
+    ws.live_end.clear();
+    if (s == t) return 0;
+    vector<Cap> excess(n, 0);
+    for (int a = offset[s]; a < offset[s + 1]; a++) {
+        if (head[a] == s || ws.res[a] <= 0) continue;
+        excess[head[a]] += ws.res[a];
+        ws.res[rev[a]] += ws.res[a];
+        ws.res[a] = 0;
+    }
+    vector<int>& level = ws.level;
+    vector<int>& gap = ws.gap;
+    vector<int>& cur = ws.cur;
+    // active[k]: The first active node with label k, linked by next_active.
+    // first[k]: The first node with label k, linked by next_node / prev_node.
+    vector<int> active(n, -1), next_active(n, -1), first(n, -1), next_node(n, -1), prev_node(n, -1);
+    int highest = 0, max_level = 0;
+    auto insert_node = [&](int v) {
+        int k = level[v];
+        prev_node[v] = -1;
+        next_node[v] = first[k];
+        if (first[k] >= 0) prev_node[first[k]] = v;
+        first[k] = v;
+        max_level = max(max_level, k);
+    };
+    auto erase_node = [&](int v) {
+        if (prev_node[v] >= 0) {
+            next_node[prev_node[v]] = next_node[v];
+        } else {
+            first[level[v]] = next_node[v];
+        }
+        if (next_node[v] >= 0) prev_node[next_node[v]] = prev_node[v];
+    };
+    auto activate = [&](int v) {
+        next_active[v] = active[level[v]];
+        active[level[v]] = v;
+        highest = max(highest, level[v]);
+    };
+    auto relabel_all = [&]() {
+        bfs(ws, t);
+        gap[level[s]]--;
+        level[s] = n;
+        gap[n]++;
+        fill(active.begin(), active.end(), -1);
+        fill(first.begin(), first.end(), -1);
+        highest = max_level = 0;
+        for (int v = 0; v < n; v++) {
+            if (level[v] >= n) continue;
+            insert_node(v);
+            if (v != t && excess[v] > 0) activate(v);
+        }
+        cur.assign(offset.begin(), offset.end() - 1);
+    };
+    relabel_all();
+    const long long work_limit = 6LL * n + (long long)head.size();
+    long long work = 0;
+
+    while (highest >= 0) {
+        int v = active[highest];
+        if (v < 0) {
+            highest--;
+            continue;
+        }
+        active[highest] = next_active[v];
+        if (level[v] != highest || excess[v] <= 0) continue;
+        // Discharge v: push over admissible arcs from its current arc on, relabel when they run out.
+        while (excess[v] > 0) {
+            if (cur[v] == offset[v + 1]) {
+                int old = level[v];
+                if (gap[old] == 1) {
+                    // v is the last node at its label, so nothing at or above it can reach t any more.
+                    for (int k = old; k <= max_level; k++) {
+                        for (int u = first[k]; u >= 0; u = next_node[u]) {
+                            gap[k]--;
+                            level[u] = n;
+                            gap[n]++;
+                        }
+                        first[k] = -1;
+                        active[k] = -1;
+                    }
+                    max_level = old - 1;
+                    break;
+                }
+                int best = n;
+                for (int a = offset[v]; a < offset[v + 1]; a++) {
+                    if (ws.res[a] > 0) best = min(best, level[head[a]] + 1);
+                }
+                work += offset[v + 1] - offset[v];
+                erase_node(v);
+                gap[old]--;
+                level[v] = best;
+                gap[best]++;
+                cur[v] = offset[v];
+                if (best >= n) break;
+                insert_node(v);
+                continue;
+            }
+            int a = cur[v];
+            int w = head[a];
+            if (ws.res[a] > 0 && level[v] == level[w] + 1) {
+                Cap delta = min(excess[v], (Cap)ws.res[a]);
+                ws.res[a] -= delta;
+                ws.res[rev[a]] += delta;
+                excess[v] -= delta;
+                if (w != t && excess[w] <= 0 && excess[w] + delta > 0) activate(w);
+                excess[w] += delta;
+                if (excess[v] <= 0) break;
+            }
+            cur[v]++;
+        }
+        if (level[v] < n) highest = max(highest, level[v]);
+        if (work >= work_limit) {
+            work = 0;
+            relabel_all();
+        }
+    }
+
+    Cap flow = excess[t];
+    unique_ptr<atomic<Cap>[]> shared(new atomic<Cap>[n]);
+    for (int v = 0; v < n; v++) shared[v].store(excess[v], memory_order_relaxed);
+    vector<int> label;
+    push_relabel_phase(shared.get(), label, s, t, 1);
+    ws.labels_valid = false;
+    return flow;
+}
+
+template int BasicIsap<int>::push_relabel(int, int, int);
+template long long BasicIsap<long long>::push_relabel(int, int, int);
+template double BasicIsap<double>::push_relabel(int, int, int);
+template long long BasicIsap<long long, uint32_t>::push_relabel(int, int, int);
+template int BasicIsap<int>::highest_label_push_relabel(int, int);
+template long long BasicIsap<long long>::highest_label_push_relabel(int, int);
+template double BasicIsap<double>::highest_label_push_relabel(int, int);
+template long long BasicIsap<long long, uint32_t>::highest_label_push_relabel(int, int);
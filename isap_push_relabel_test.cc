@@ -0,0 +1,96 @@
+#include "isap.h"
+#include <cassert>
+#include <random>
+
+int main() {
+  // Test case 1: The sample graph through the dispatcher, on either engine
+  for (Engine engine : {Engine::Isap, Engine::ParallelPushRelabel, Engine::HighestLabel}) {
+    Isap g(6);
+    g.add_edge(0, 1, 16);
+    g.add_edge(0, 2, 13);
+    g.add_edge(1, 2, 10);
+    g.add_edge(2, 1, 4);
+    g.add_edge(1, 3, 12);
+    g.add_edge(2, 4, 14);
+    g.add_edge(3, 2, 9);
+    g.add_edge(4, 3, 7);
+    g.add_edge(3, 5, 20);
+    g.add_edge(4, 5, 4);
+    assert(g.max_flow(0, 5, engine, 4) == 23);
+  }
+
+  // Test case 2: Random graphs agree with isap(), and the result is a flow whose minimum cut matches its value
+  mt19937 rng(2);
+  for (int round = 0; round < 40; round++) {
+    int n = 30;
+    BasicIsap<long long> seq(n), par(n);
+    for (int i = 0; i < 150; i++) {
+      int u = rng() % n, v = rng() % n;
+      long long cap = rng() % 50;
+      seq.add_edge(u, v, cap);
+      par.add_edge(u, v, cap);
+    }
+    long long expected = seq.isap(0, n - 1);
+    assert(par.push_relabel(0, n - 1, 1 + round % 4) == expected);
+    for (int id = 0; id < par.edge_count(); id++) {
+      BasicEdge<long long> e = par.get_edge(id);
+      assert(e.flow >= 0 && e.flow <= e.cap);
+    }
+    vector<bool> side = par.min_cut_source_side();
+    long long cut = 0;
+    for (int id : par.min_cut_edges()) cut += par.get_edge(id).cap;
+    assert(side[0] && !side[n - 1] && cut == expected);
+    // augment() continues from the flow the parallel engine left
+    par.add_edge(0, n - 1, 5);
+    assert(par.augment(0, n - 1) == 5);
+  }
+
+  // Test case 3: Flow conservation and fractional capacities
+  BasicIsap<double> frac(4);
+  frac.add_edge(0, 1, 1.5);
+  frac.add_edge(0, 2, 2.25);
+  frac.add_edge(1, 3, 2.0);
+  frac.add_edge(2, 3, 1.0);
+  frac.add_edge(2, 1, 1.0);
+  assert(frac.push_relabel(0, 3, 2) == 3.0);
+  assert(frac.get_edge(0).flow + frac.get_edge(4).flow == frac.get_edge(2).flow);
+
+  // Test case 4: Highest-label push-relabel agrees with isap() on sparse and dense random graphs
+  for (int round = 0; round < 60; round++) {
+    int n = round % 2 ? 12 : 40;
+    int m = round % 2 ? 120 : 100;
+    BasicIsap<long long> seq(n), hl(n);
+    vector<int> tails;
+    for (int i = 0; i < m; i++) {
+      int u = rng() % n, v = rng() % n;
+      long long cap = rng() % 30;
+      seq.add_edge(u, v, cap);
+      hl.add_edge(u, v, cap);
+      tails.push_back(u);
+    }
+    long long expected = seq.isap(0, n - 1);
+    assert(hl.highest_label_push_relabel(0, n - 1) == expected);
+    vector<long long> balance(n, 0);
+    for (int id = 0; id < m; id++) {
+      balance[tails[id]] -= hl.get_edge(id).flow;
+      balance[hl.get_edge(id).to] += hl.get_edge(id).flow;
+    }
+    for (int v = 1; v < n - 1; v++) assert(balance[v] == 0);
+    assert(balance[n - 1] == expected);
+    long long cut = 0;
+    for (int id : hl.min_cut_edges()) cut += hl.get_edge(id).cap;
+    assert(cut == expected);
+    hl.add_edge(0, n - 1, 2);
+    assert(hl.highest_label_push_relabel(0, n - 1) == 2);
+    assert(hl.augment(0, n - 1) == 0);
+  }
+  BasicIsap<double> hl_frac(4);
+  hl_frac.add_edge(0, 1, 1.5);
+  hl_frac.add_edge(0, 2, 2.25);
+  hl_frac.add_edge(1, 3, 2.0);
+  hl_frac.add_edge(2, 3, 1.0);
+  hl_frac.add_edge(2, 1, 1.0);
+  assert(hl_frac.highest_label_push_relabel(0, 3) == 3.0);
+
+  return 0;
+}
@@ -1,5 +1,39 @@
 #include "isap.h"
 #include <cassert>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <random>
+#include <thread>
+
+/**
+ * @brief Maximum flow by Edmonds-Karp on a capacity matrix, as a reference independent of the solver.
+ */
+static long long reference_max_flow(vector<vector<long long>> cap, int s, int t) {
+  int n = cap.size();
+  long long flow = 0;
+  while (true) {
+    vector<int> parent(n, -1);
+    parent[s] = s;
+    vector<int> q(1, s);
+    for (int i = 0; i < (int)q.size() && parent[t] < 0; i++) {
+      for (int v = 0; v < n; v++) {
+        if (parent[v] < 0 && cap[q[i]][v] > 0) {
+          parent[v] = q[i];
+          q.push_back(v);
+        }
+      }
+    }
+    if (parent[t] < 0) return flow;
+    long long f = LLONG_MAX;
+    for (int v = t; v != s; v = parent[v]) f = min(f, cap[parent[v]][v]);
+    for (int v = t; v != s; v = parent[v]) {
+      cap[parent[v]][v] -= f;
+      cap[v][parent[v]] += f;
+    }
+    flow += f;
+  }
+}
 
 int main() {
   // Test case 1: Simple graph
@@ -30,5 +64,640 @@ int main() {
   graph3.add_edge(0, 1, 10);
   assert(graph3.isap(0, 2) == 0);
 
+  // Test case 4: Edges added after a solve keep the flow found so far
+  graph3.add_edge(1, 2, 4);
+  assert(graph3.isap(0, 2) == 4);
+  graph3.add_edge(0, 2, 3);
+  assert(graph3.isap(0, 2) == 3);
+
+  // Test case 5: Per-edge flows are readable after the solve
+  vector<int> inflow(4, 0);
+  for (int id = 0; id < graph1.edge_count(); id++) {
+    Edge e = graph1.get_edge(id);
+    assert(0 <= e.flow && e.flow <= e.cap);
+    inflow[e.to] += e.flow;
+  }
+  assert(graph1.get_edge(0).flow + graph1.get_edge(1).flow == 12);
+  assert(inflow[3] == 12);
+
+  // Test case 6: Capacities whose sum overflows int
+  BasicIsap<long long> graph6(3);
+  graph6.add_edge(0, 1, 3000000000LL);
+  graph6.add_edge(0, 1, 3000000000LL);
+  graph6.add_edge(1, 2, CapTraits<long long>::inf());
+  assert(graph6.isap(0, 2) == 6000000000LL);
+
+  // Test case 7: 32-bit residual storage with a 64-bit flow value
+  BasicIsap<long long, uint32_t> graph7(3);
+  graph7.add_edge(0, 1, 4000000000U);
+  graph7.add_edge(0, 1, 4000000000U);
+  graph7.add_edge(1, 2, 4000000000U);
+  graph7.add_edge(1, 2, 4000000000U);
+  assert(graph7.isap(0, 2) == 8000000000LL);
+  // Capacities beyond 32 bits are clamped, not truncated: 2^32 + 5 would otherwise become 5
+  BasicIsap<long long, uint32_t> clamped(3);
+  clamped.add_edge(0, 1, (1LL << 32) + 5);
+  clamped.add_edge(1, 2, 1000);
+  assert(clamped.isap(0, 2) == 1000 && clamped.get_edge(0).cap == UINT32_MAX);
+  clamped.set_capacity(1, 2000);
+  clamped.set_capacity(0, 1LL << 40);
+  assert(clamped.augment(0, 2) == 1000 && clamped.get_edge(0).cap == UINT32_MAX);
+
+  // Test case 8: Fractional capacities
+  BasicIsap<double> graph8(3);
+  graph8.add_edge(0, 1, 0.5);
+  graph8.add_edge(1, 2, 0.25);
+  graph8.add_edge(0, 2, 0.125);
+  assert(graph8.isap(0, 2) == 0.375);
+
+  // Test case 9: Reset flows and re-solve without rebuilding
+  graph2.reset_flows();
+  assert(graph2.isap(0, 5) == 23);
+  graph2.reset_flows();
+  graph2.set_capacity(9, 10);
+  assert(graph2.isap(0, 5) == 26);
+  graph2.set_capacity(0, 26);
+  assert(graph2.isap(0, 5) == 0);
+
+  // Test case 10: Warm-started augment() after capacity increases and new edges matches a fresh solve
+  mt19937 rng(10);
+  Isap graph10(30);
+  vector<int> from, to, cap;
+  for (int i = 0; i < 120; i++) {
+    from.push_back(rng() % 30);
+    to.push_back(rng() % 30);
+    cap.push_back(rng() % 10);
+    graph10.add_edge(from[i], to[i], cap[i]);
+  }
+  int total = graph10.augment(0, 29);
+  for (int round = 0; round < 50; round++) {
+    if (round % 5 == 0) {
+      from.push_back(rng() % 30);
+      to.push_back(rng() % 30);
+      cap.push_back(rng() % 10);
+      graph10.add_edge(from.back(), to.back(), cap.back());
+    } else {
+      int id = rng() % cap.size();
+      cap[id] += rng() % 5;
+      graph10.set_capacity(id, cap[id]);
+    }
+    total += graph10.augment(0, 29);
+    Isap fresh(30);
+    for (int i = 0; i < (int)cap.size(); i++) {
+      fresh.add_edge(from[i], to[i], cap[i]);
+    }
+    assert(total == fresh.isap(0, 29));
+  }
+
+  // Test case 11: Periodic global relabels do not change the result
+  for (double k : {0.05, 0.5, 2.0}) {
+    Isap relabeled(30);
+    for (int i = 0; i < (int)cap.size(); i++) {
+      relabeled.add_edge(from[i], to[i], cap[i]);
+    }
+    GlobalRelabelPolicy policy;
+    policy.relabels_per_node = k;
+    relabeled.set_global_relabel_policy(policy);
+    assert(relabeled.isap(0, 29) == total);
+  }
+  Isap scanned(30);
+  for (int i = 0; i < (int)cap.size(); i++) {
+    scanned.add_edge(from[i], to[i], cap[i]);
+  }
+  GlobalRelabelPolicy policy;
+  policy.arc_scans_per_arc = 0.1;
+  scanned.set_global_relabel_policy(policy);
+  assert(scanned.isap(0, 29) == total);
+  assert(scanned.global_relabel_count() > 0);
+
+  // Test case 12: Both augmentation modes find the same maximum flow
+  for (int seed = 0; seed < 20; seed++) {
+    mt19937 gen(seed);
+    Isap restart(40), retreat(40);
+    restart.set_augment_mode(AugmentMode::Restart);
+    retreat.set_augment_mode(AugmentMode::Retreat);
+    for (int i = 0; i < 200; i++) {
+      int u = gen() % 40, v = gen() % 40, c = gen() % 20;
+      restart.add_edge(u, v, c);
+      retreat.add_edge(u, v, c);
+    }
+    assert(restart.isap(0, 39) == retreat.isap(0, 39));
+  }
+
+  // Test case 13: The minimum cut separates s from t and its capacity equals the maximum flow
+  for (int seed = 0; seed < 20; seed++) {
+    mt19937 gen(seed);
+    Isap graph(40);
+    for (int i = 0; i < 200; i++) {
+      graph.add_edge(gen() % 40, gen() % 40, gen() % 20);
+    }
+    int max_flow = graph.isap(0, 39);
+    vector<bool> side = graph.min_cut_source_side();
+    assert(side[0] && !side[39]);
+    int cut = 0;
+    for (int id : graph.min_cut_edges()) {
+      Edge e = graph.get_edge(id);
+      assert(e.flow == e.cap);
+      cut += e.cap;
+    }
+    assert(cut == max_flow);
+    // After a change, the cut is recomputed from the residual graph
+    graph.set_capacity(0, graph.get_edge(0).cap);
+    int reachable_cut = 0;
+    for (int id : graph.min_cut_edges()) {
+      reachable_cut += graph.get_edge(id).cap;
+    }
+    assert(reachable_cut == max_flow);
+  }
+
+  // Test case 14: Work counters are maintained only when compiled in
+  Isap counted(4);
+  counted.add_edge(0, 1, 10);
+  counted.add_edge(1, 3, 4);
+  counted.add_edge(0, 2, 5);
+  counted.add_edge(2, 3, 5);
+  assert(counted.isap(0, 3) == 9);
+  IsapStats stats = counted.stats();
+  if (Isap::stats_enabled()) {
+    assert(stats.augmentations == 2 && stats.path_length == 4 && stats.bfs_runs == 1);
+  } else {
+    assert(stats.augmentations == 0 && stats.bfs_runs == 0);
+  }
+  assert(stats.to_json().find("\"augmentations\": ") != string::npos);
+  counted.reset_stats();
+  assert(counted.stats().path_length == 0);
+
+  // Test case 15: A batch of (s, t) pairs on shared topology matches one solve per pair
+  mt19937 batch_rng(15);
+  Isap shared(50);
+  vector<int> batch_from, batch_to, batch_cap;
+  for (int i = 0; i < 300; i++) {
+    batch_from.push_back(batch_rng() % 50);
+    batch_to.push_back(batch_rng() % 50);
+    batch_cap.push_back(batch_rng() % 20);
+    shared.add_edge(batch_from[i], batch_to[i], batch_cap[i]);
+  }
+  vector<pair<int, int>> pairs;
+  for (int i = 0; i < 40; i++) {
+    pairs.push_back({(int)(batch_rng() % 50), (int)(batch_rng() % 50)});
+  }
+  for (int threads : {1, 4}) {
+    vector<int> flows = shared.max_flow_batch(pairs, threads);
+    for (int i = 0; i < (int)pairs.size(); i++) {
+      Isap single(50);
+      for (int j = 0; j < (int)batch_cap.size(); j++) {
+        single.add_edge(batch_from[j], batch_to[j], batch_cap[j]);
+      }
+      assert(flows[i] == single.isap(pairs[i].first, pairs[i].second));
+    }
+  }
+  for (int id = 0; id < shared.edge_count(); id++) {
+    assert(shared.get_edge(id).flow == 0);
+  }
+
+  // Test case 16: A solver with reserved storage, cleared and reused for a different graph
+  Isap reused(4, 5);
+  reused.add_edge(0, 1, 3);
+  reused.add_edge(1, 3, 2);
+  reused.add_edge(0, 2, 1);
+  reused.add_edge(2, 3, 4);
+  assert(reused.isap(0, 3) == 3);
+  reused.clear(3);
+  assert(reused.edge_count() == 0);
+  reused.add_edge(0, 1, 7);
+  reused.add_edge(1, 2, 5);
+  assert(reused.isap(0, 2) == 5);
+  assert(reused.get_edge(0).flow == 5);
+  assert((reused.min_cut_source_side() == vector<bool>{true, true, false}));
+
+  // Test case 17: Hub nodes with hundreds of arcs, whose scans take the vectorized kernels, for every residual type
+  mt19937 hub_rng(17);
+  for (int round = 0; round < 10; round++) {
+    int n = 150;
+    vector<vector<long long>> matrix(n, vector<long long>(n, 0));
+    BasicIsap<int> hub_int(n);
+    BasicIsap<long long> hub_ll(n);
+    BasicIsap<double> hub_double(n);
+    BasicIsap<long long, uint32_t> hub_narrow(n);
+    for (int i = 0; i < 1500; i++) {
+      int u = i < 600 ? hub_rng() % 4 : hub_rng() % n;
+      int v = i >= 600 && i < 1000 ? 1 + hub_rng() % 3 : hub_rng() % n;
+      int cap = hub_rng() % 10;
+      if (u == v) continue;
+      matrix[u][v] += cap;
+      hub_int.add_edge(u, v, cap);
+      hub_ll.add_edge(u, v, cap);
+      hub_double.add_edge(u, v, cap);
+      hub_narrow.add_edge(u, v, cap);
+    }
+    long long expected = reference_max_flow(matrix, 0, n - 1);
+    assert(hub_int.isap(0, n - 1) == expected);
+    assert(hub_ll.isap(0, n - 1) == expected);
+    assert(hub_double.isap(0, n - 1) == expected);
+    assert(hub_narrow.isap(0, n - 1) == expected);
+  }
+
+  // Test case 18: Internal node orders leave flows, cuts, warm starts and batches in the caller's ids unchanged
+  mt19937 order_rng(18);
+  for (NodeOrder order : {NodeOrder::Bfs, NodeOrder::ReverseCuthillMcKee, NodeOrder::Degree}) {
+    for (int round = 0; round < 20; round++) {
+      int n = 2 + order_rng() % 40;
+      BasicIsap<long long> given(n), reordered(n);
+      reordered.set_node_order(order, round % 2 ? n - 1 : -1);
+      vector<int> tail;
+      for (int i = 0; i < 4 * n; i++) {
+        int u = order_rng() % n, v = order_rng() % n, cap = order_rng() % 20;
+        given.add_edge(u, v, cap);
+        reordered.add_edge(u, v, cap);
+        tail.push_back(u);
+      }
+      long long flow = given.isap(0, n - 1);
+      assert(reordered.isap(0, n - 1) == flow);
+      vector<long long> excess(n, 0);
+      for (int id = 0; id < reordered.edge_count(); id++) {
+        BasicEdge<long long> e = reordered.get_edge(id);
+        assert(e.flow >= 0 && e.flow <= e.cap);
+        excess[tail[id]] -= e.flow;
+        excess[e.to] += e.flow;
+      }
+      for (int v = 1; v < n - 1; v++) assert(excess[v] == 0);
+      assert(excess[n - 1] == flow);
+      vector<bool> side = reordered.min_cut_source_side();
+      assert(side[0] && !side[n - 1]);
+      long long cut = 0;
+      for (int id : reordered.min_cut_edges()) cut += reordered.get_edge(id).cap;
+      assert(cut == flow);
+      int added = reordered.add_edge(0, n - 1, 5);
+      given.add_edge(0, n - 1, 5);
+      assert(reordered.augment(0, n - 1) == given.augment(0, n - 1));
+      assert(reordered.get_edge(added).flow == 5);
+      vector<vector<bool>> sides;
+      vector<long long> batch = reordered.max_flow_batch({{0, n - 1}, {n - 1, 0}}, 2, &sides);
+      assert(batch[0] == flow + 5);
+      assert(sides[0][0] && !sides[0][n - 1]);
+      assert(sides[1][n - 1] && !sides[1][0]);
+    }
+  }
+
+  // Test case 19: Arc partitioning matches unpartitioned solves through saturations, revivals, self-loops and warm starts
+  mt19937 partition_rng(19);
+  long long dead_arc_skips = 0;
+  for (AugmentMode mode : {AugmentMode::Restart, AugmentMode::Retreat}) {
+    for (int round = 0; round < 30; round++) {
+      int n = 2 + partition_rng() % 30;
+      BasicIsap<double> plain(n), partitioned(n);
+      partitioned.set_arc_partitioning(true);
+      plain.set_augment_mode(mode);
+      partitioned.set_augment_mode(mode);
+      vector<int> tail;
+      for (int i = 0; i < 5 * n; i++) {
+        int u = partition_rng() % n, v = partition_rng() % n, cap = partition_rng() % 10;
+        plain.add_edge(u, v, cap);
+        partitioned.add_edge(u, v, cap);
+        tail.push_back(u);
+      }
+      assert(partitioned.isap(0, n - 1) == plain.isap(0, n - 1));
+      for (int id = 0; id < 5 * n; id += 3) {
+        int cap = partition_rng() % 15;
+        plain.reset_flows();
+        partitioned.reset_flows();
+        plain.set_capacity(id, cap);
+        partitioned.set_capacity(id, cap);
+      }
+      partitioned.add_edge(0, n - 1, 2);
+      plain.add_edge(0, n - 1, 2);
+      tail.push_back(0);
+      double flow = plain.isap(0, n - 1);
+      assert(partitioned.isap(0, n - 1) == flow);
+      plain.set_capacity(0, plain.get_edge(0).cap + 4);
+      partitioned.set_capacity(0, partitioned.get_edge(0).cap + 4);
+      double more = plain.augment(0, n - 1);
+      assert(partitioned.augment(0, n - 1) == more);
+      // Updates between solves only repartition the nodes they touch.
+      vector<BasicEdgeUpdate<double>> updates = {{UpdateKind::SetCapacity, 1, 0, 0, 1}, {UpdateKind::Remove, 2, 0, 0, 0}};
+      double change = plain.apply_updates(updates, 0, n - 1);
+      assert(partitioned.apply_updates(updates, 0, n - 1) == change);
+      more += change;
+      plain.set_capacity(3, plain.get_edge(3).cap + 5);
+      partitioned.set_capacity(3, partitioned.get_edge(3).cap + 5);
+      plain.set_capacity(4, plain.get_edge(4).cap + 3);
+      partitioned.set_capacity(4, partitioned.get_edge(4).cap + 3);
+      change = plain.augment(0, n - 1);
+      assert(partitioned.augment(0, n - 1) == change);
+      more += change;
+      vector<double> excess(n, 0);
+      for (int id = 0; id < partitioned.edge_count(); id++) {
+        BasicEdge<double> e = partitioned.get_edge(id);
+        assert(e.flow >= 0 && e.flow <= e.cap);
+        excess[tail[id]] -= e.flow;
+        excess[e.to] += e.flow;
+      }
+      for (int v = 1; v < n - 1; v++) assert(excess[v] == 0);
+      assert(excess[n - 1] == flow + more);
+      double cut = 0;
+      for (int id : partitioned.min_cut_edges()) cut += partitioned.get_edge(id).cap;
+      assert(cut == flow + more);
+      dead_arc_skips += partitioned.stats().dead_arc_skips;
+    }
+  }
+  assert(Isap::stats_enabled() ? dead_arc_skips > 0 : dead_arc_skips == 0);
+
+  // Test case 20: Batches of capacity changes, removals and insertions keep a maximum flow, checked against fresh solves
+  mt19937 update_rng(20);
+  for (int round = 0; round < 40; round++) {
+    int n = 2 + update_rng() % 25;
+    Isap dynamic(n);
+    BasicIsap<double> dynamic_double(n);
+    if (round % 2) dynamic.set_node_order(NodeOrder::Bfs, n - 1);
+    vector<int> tail, to, cap;
+    for (int i = 0; i < 4 * n; i++) {
+      tail.push_back(update_rng() % n);
+      to.push_back(update_rng() % n);
+      cap.push_back(update_rng() % 20);
+      dynamic.add_edge(tail.back(), to.back(), cap.back());
+      dynamic_double.add_edge(tail.back(), to.back(), cap.back());
+    }
+    int flow = dynamic.isap(0, n - 1);
+    double flow_double = dynamic_double.isap(0, n - 1);
+    for (int batch = 0; batch < 5; batch++) {
+      vector<EdgeUpdate> updates;
+      vector<BasicEdgeUpdate<double>> updates_double;
+      for (int k = 0; k < 1 + (int)(update_rng() % 6); k++) {
+        int kind = update_rng() % 3, id = update_rng() % tail.size();
+        if (kind == 0) {
+          cap[id] = update_rng() % 25;
+          updates.push_back({UpdateKind::SetCapacity, id, 0, 0, cap[id]});
+        } else if (kind == 1) {
+          cap[id] = 0;
+          updates.push_back({UpdateKind::Remove, id, 0, 0, 0});
+        } else {
+          tail.push_back(update_rng() % n);
+          to.push_back(update_rng() % n);
+          cap.push_back(update_rng() % 20);
+          updates.push_back({UpdateKind::Insert, -1, tail.back(), to.back(), cap.back()});
+        }
+        const EdgeUpdate& u = updates.back();
+        updates_double.push_back({u.kind, u.id, u.from, u.to, (double)u.cap});
+      }
+      Isap fresh(n);
+      for (int id = 0; id < (int)tail.size(); id++) fresh.add_edge(tail[id], to[id], cap[id]);
+      int expected = fresh.isap(0, n - 1);
+      flow += dynamic.apply_updates(updates, 0, n - 1);
+      flow_double += dynamic_double.apply_updates(updates_double, 0, n - 1);
+      assert(flow == expected && flow_double == expected);
+      vector<int> excess(n, 0);
+      for (int id = 0; id < dynamic.edge_count(); id++) {
+        Edge e = dynamic.get_edge(id);
+        assert(e.cap == cap[id] && e.flow >= 0 && e.flow <= e.cap);
+        excess[tail[id]] -= e.flow;
+        excess[e.to] += e.flow;
+      }
+      for (int v = 1; v < n - 1; v++) assert(excess[v] == 0);
+      assert(excess[n - 1] == flow);
+      int cut = 0;
+      for (int id : dynamic.min_cut_edges()) cut += dynamic.get_edge(id).cap;
+      assert(cut == flow);
+    }
+  }
+
+  // Test case 21: Source and sink sets agree with super nodes, without their INF arcs capping the flow
+  mt19937 terminal_rng(21);
+  for (int round = 0; round < 40; round++) {
+    int n = 4 + terminal_rng() % 30;
+    BasicIsap<long long> multi(n), wired(n + 2);
+    if (round % 3 == 1) multi.set_arc_partitioning(true);
+    if (round % 3 == 2) multi.set_augment_mode(AugmentMode::Restart);
+    vector<int> tail;
+    for (int i = 0; i < 4 * n; i++) {
+      int u = terminal_rng() % n, v = terminal_rng() % n, cap = terminal_rng() % 20;
+      multi.add_edge(u, v, cap);
+      wired.add_edge(u, v, cap);
+      tail.push_back(u);
+    }
+    vector<int> sources, sinks;
+    vector<bool> is_source(n, false), is_sink(n, false);
+    for (int k = 0; k < 1 + (int)(terminal_rng() % 4); k++) {
+      int v = terminal_rng() % n;
+      if (!is_sink[v]) {
+        sources.push_back(v);
+        is_source[v] = true;
+      }
+      v = terminal_rng() % n;
+      if (!is_source[v]) {
+        sinks.push_back(v);
+        is_sink[v] = true;
+      }
+    }
+    for (int v : sources) wired.add_edge(n, v, 1000000);
+    for (int v : sinks) wired.add_edge(v, n + 1, 1000000);
+    long long flow = multi.isap(sources, sinks);
+    assert(flow == wired.isap(n, n + 1));
+    vector<long long> excess(n, 0);
+    for (int id = 0; id < multi.edge_count(); id++) {
+      BasicEdge<long long> e = multi.get_edge(id);
+      excess[tail[id]] -= e.flow;
+      excess[e.to] += e.flow;
+    }
+    long long into_sinks = 0;
+    for (int v = 0; v < n; v++) {
+      if (is_sink[v]) into_sinks += excess[v];
+      else if (!is_source[v]) assert(excess[v] == 0);
+    }
+    assert(into_sinks == flow);
+    vector<bool> side = multi.min_cut_source_side();
+    for (int v : sources) assert(side[v]);
+    for (int v : sinks) assert(!side[v]);
+    long long cut = 0;
+    for (int id : multi.min_cut_edges()) cut += multi.get_edge(id).cap;
+    assert(cut == flow);
+  }
+  Isap wide(5);
+  for (int v = 1; v <= 3; v++) {
+    wide.add_edge(0, v, 600000000);
+    wide.add_edge(v, 4, 600000000);
+  }
+  // A super source or sink arc of capacity INF would cap both flows at 10^9.
+  assert(wide.isap({0}, {1, 2, 3}) == 1800000000);
+  assert(wide.isap({1, 2, 3}, {4}) == 1800000000);
+  // A source that is also a sink adds nothing and lies on the sink side
+  Isap overlap(3);
+  overlap.add_edge(0, 1, 4);
+  overlap.add_edge(1, 2, 3);
+  assert(overlap.isap({0, 1}, {1, 2}) == 4);
+  vector<bool> overlap_side = overlap.min_cut_source_side();
+  assert(overlap_side[0] && !overlap_side[1] && !overlap_side[2]);
+
+  // Test case 22: Capacity scaling over capacities from 1 to 10^12 agrees with the reference, in both augment modes,
+  // with arc partitioning, for narrow and floating-point residuals, and leaves a minimum cut and a resumable flow
+  mt19937 scaling_rng(22);
+  for (int round = 0; round < 60; round++) {
+    int n = 2 + scaling_rng() % 30;
+    vector<vector<long long>> matrix(n, vector<long long>(n, 0)), narrow_matrix = matrix;
+    BasicIsap<long long> retreat(n), restart(n), partitioned(n);
+    BasicIsap<long long, uint32_t> narrow(n);
+    BasicIsap<double> floating(n);
+    restart.set_augment_mode(AugmentMode::Restart);
+    partitioned.set_arc_partitioning(true);
+    for (auto* g : {&retreat, &restart, &partitioned}) g->set_capacity_scaling(true);
+    narrow.set_capacity_scaling(true);
+    floating.set_capacity_scaling(true);
+    for (int i = 0; i < 5 * n; i++) {
+      int u = scaling_rng() % n, v = scaling_rng() % n;
+      long long cap = 1 + scaling_rng() % 1000000;
+      if (scaling_rng() % 2) cap *= 1000000 * (long long)(scaling_rng() % 3);
+      if (u == v) continue;
+      matrix[u][v] += cap;
+      for (auto* g : {&retreat, &restart, &partitioned}) g->add_edge(u, v, cap);
+      narrow_matrix[u][v] += cap % 4000000000LL;
+      narrow.add_edge(u, v, cap % 4000000000LL);
+      floating.add_edge(u, v, (double)cap);
+    }
+    long long expected = reference_max_flow(matrix, 0, n - 1);
+    for (auto* g : {&retreat, &restart, &partitioned}) {
+      assert(g->isap(0, n - 1) == expected);
+      long long cut = 0;
+      for (int id : g->min_cut_edges()) cut += g->get_edge(id).cap;
+      assert(cut == expected);
+      g->add_edge(0, n - 1, 5);
+      assert(g->augment(0, n - 1) == 5);
+    }
+    assert(narrow.isap(0, n - 1) == reference_max_flow(narrow_matrix, 0, n - 1));
+    assert(fabs(floating.isap(0, n - 1) - expected) <= 1e-6 * expected);
+  }
+  // Infinite super source and sink arcs do not set the first phase: capacities up to 100 take the phases 64 .. 2
+  BasicIsap<long long> hubs(22);
+  hubs.set_capacity_scaling(true);
+  vector<vector<long long>> hub_matrix(22, vector<long long>(22, 0));
+  for (int v = 1; v <= 10; v++) {
+    hubs.add_edge(0, v, CapTraits<long long>::inf());
+    hubs.add_edge(10 + v, 21, CapTraits<long long>::inf());
+    hub_matrix[0][v] = hub_matrix[10 + v][21] = CapTraits<long long>::inf();
+  }
+  for (int i = 0; i < 60; i++) {
+    int u = 1 + scaling_rng() % 20, v = 1 + scaling_rng() % 20;
+    long long cap = 1 + scaling_rng() % 100;
+    if (u == v) continue;
+    hubs.add_edge(u, v, cap);
+    hub_matrix[u][v] += cap;
+  }
+  hubs.reset_stats();
+  assert(hubs.isap(0, 21) == reference_max_flow(hub_matrix, 0, 21));
+  // The initial and final BFS, one per phase and the global relabels of the phases
+  assert(!Isap::stats_enabled() || hubs.stats().bfs_runs - hubs.global_relabel_count() <= 2 + 6);
+
+  // Test case 23: A solve stopped by cancel or its deadline returns a valid flow and an upper bound, and augment()
+  // resumes it; a completed solve publishes its exact flow, also while another thread watches it
+  int strip_w = 2000, strip_h = 8, strip_n = strip_w * strip_h + 2;
+  int strip_s = strip_n - 2, strip_t = strip_n - 1;
+  vector<array<int, 3>> strip;
+  mt19937 strip_rng(23);
+  for (int y = 0; y < strip_h; y++) {
+    strip.push_back({strip_s, y * strip_w, INF});
+    strip.push_back({y * strip_w + strip_w - 1, strip_t, INF});
+    for (int x = 0; x < strip_w; x++) {
+      int v = y * strip_w + x;
+      if (x + 1 < strip_w) strip.push_back({v, v + 1, 1 + (int)(strip_rng() % 100)});
+      if (y + 1 < strip_h) {
+        strip.push_back({v, v + strip_w, 1 + (int)(strip_rng() % 100)});
+        strip.push_back({v + strip_w, v, 1 + (int)(strip_rng() % 100)});
+      }
+    }
+  }
+  auto make_strip = [&](bool scaling) {
+    Isap g(strip_n);
+    g.set_capacity_scaling(scaling);
+    for (auto& e : strip) g.add_edge(e[0], e[1], e[2]);
+    return g;
+  };
+  // Checks capacities and conservation, and returns the flow value into t.
+  auto strip_value = [&](const Isap& g) {
+    vector<long long> balance(strip_n, 0);
+    for (int id = 0; id < g.edge_count(); id++) {
+      Edge e = g.get_edge(id);
+      assert(e.flow >= 0 && e.flow <= e.cap);
+      balance[strip[id][0]] -= e.flow;
+      balance[strip[id][1]] += e.flow;
+    }
+    for (int v = 0; v < strip_s; v++) assert(balance[v] == 0);
+    return balance[strip_t];
+  };
+  Isap strip_plain = make_strip(false);
+  int strip_max = strip_plain.isap(strip_s, strip_t);
+
+  SolveProgress finished;
+  Isap watched = make_strip(false);
+  watched.set_progress(&finished);
+  assert(watched.isap(strip_s, strip_t) == strip_max);
+  assert(finished.done && !finished.stopped && finished.flow == strip_max && finished.upper_bound == strip_max);
+  assert(finished.nodes == strip_n);
+
+  for (int variant = 0; variant < 3; variant++) {
+    SolveProgress progress;
+    if (variant == 1) {
+      progress.deadline = chrono::steady_clock::now();
+    } else {
+      progress.cancel = true;
+    }
+    Isap g = make_strip(variant == 2);
+    g.set_progress(&progress);
+    int flow = g.isap(strip_s, strip_t);
+    assert(progress.done && progress.stopped && progress.flow == flow);
+    assert(flow < strip_max && progress.upper_bound >= strip_max);
+    assert(strip_value(g) == flow);
+    vector<bool> side = g.min_cut_source_side();
+    assert(side[strip_s] && !side[strip_t]);
+    g.set_progress(nullptr);
+    assert(flow + g.augment(strip_s, strip_t) == strip_max);
+  }
+
+  // A scaling solve stopped after its phases publishes their flow too, so its bound stays above the flow it returns
+  int grid_w = 300, grid_h = 150, grid_n = grid_w * grid_h + 3;
+  int grid_s = grid_n - 3, grid_a = grid_n - 2, grid_t = grid_n - 1;
+  BasicIsap<long long> grid(grid_n);
+  grid.set_capacity_scaling(true);
+  for (int y = 0; y < grid_h; y++) {
+    grid.add_edge(grid_s, y * grid_w, 1);
+    grid.add_edge(y * grid_w + grid_w - 1, grid_t, 1);
+    for (int x = 0; x < grid_w; x++) {
+      int v = y * grid_w + x;
+      if (x + 1 < grid_w) grid.add_edge(v, v + 1, 1);
+      if (y + 1 < grid_h) {
+        grid.add_edge(v, v + grid_w, 1);
+        grid.add_edge(v + grid_w, v, 1);
+      }
+    }
+  }
+  grid.add_edge(grid_s, grid_a, 1LL << 40);
+  grid.add_edge(grid_a, grid_t, 1LL << 40);
+  BasicSolveProgress<long long> grid_progress;
+  grid_progress.cancel = true;
+  grid.set_progress(&grid_progress);
+  long long grid_flow = grid.isap(grid_s, grid_t);
+  assert(grid_progress.stopped && grid_progress.flow == grid_flow);
+  assert(grid_flow >= (1LL << 40) && grid_flow < (1LL << 40) + grid_h);
+  assert(grid_flow <= grid_progress.upper_bound && grid_progress.upper_bound >= (1LL << 40) + grid_h);
+  vector<bool> grid_side = grid.min_cut_source_side();
+  assert(grid_side[grid_s] && !grid_side[grid_t]);
+  grid.set_progress(nullptr);
+  assert(grid_flow + grid.augment(grid_s, grid_t) == (1LL << 40) + grid_h);
+
+  SolveProgress shared_progress;
+  Isap monitored = make_strip(false);
+  monitored.set_progress(&shared_progress);
+  thread monitor([&]() {
+    while (!shared_progress.done) {
+      if (shared_progress.flow > strip_max / 2) shared_progress.cancel = true;
+      assert(shared_progress.source_level < strip_n || shared_progress.done);
+    }
+  });
+  int monitored_flow = monitored.isap(strip_s, strip_t);
+  monitor.join();
+  assert(shared_progress.upper_bound >= strip_max && monitored_flow <= strip_max);
+  assert(shared_progress.stopped || monitored_flow == strip_max);
+  assert(strip_value(monitored) == monitored_flow);
+  shared_progress.cancel = false;
+  assert(monitored_flow + monitored.augment(strip_s, strip_t) == strip_max);
+  assert(shared_progress.done && !shared_progress.stopped && shared_progress.upper_bound == shared_progress.flow);
+
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "isap.h"
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Returns whether every arc of the graph has residual 0 or 1, i.e. all capacities are 0 or 1 and the flow
+ *        is integral, so unit_capacity_flow() can run on it.
+ * @note Time Complexity: O(E).
+ */
+template <typename Cap, typename Res>
+bool BasicIsap<Cap, Res>::has_unit_capacities() const {
+    if (!built) {
+        for (int id = 0; id < (int)edge_cap.size(); id++) {
+            if (edge_cap[id] != 0 && edge_cap[id] != 1) return false;
+        }
+        for (int id = 0; id < (int)edge_arc.size(); id++) {
+            Res flow = edge_cap[id] - ws.res[edge_arc[id]];
+            if (flow != 0 && flow != 1) return false;
+        }
+        return true;
+    }
+    for (Res r : ws.res) {
+        if (r != 0 && r != 1) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Computes the maximum flow from s to t on a graph whose residuals are all 0 or 1 (see has_unit_capacities()),
+ *        starting from the current flow like isap(); for bipartite matching and other unit-capacity networks.
+ * @note Residuals are packed into one bit per arc for the duration of the solve, so the arc scans read head and a
+ *       bit instead of head and a full residual. Augmentation runs in phases, Hopcroft-Karp style: a BFS from s labels
+ *       the nodes by distance, then a depth-first search with current arcs finds a blocking flow of shortest paths.
+ *       Every augmenting path carries exactly one unit, so no bottleneck is computed; its arcs are flipped and the
+ *       search restarts from s. A node whose arcs are exhausted is removed from the phase.
+ * @note On a graph with any other residual, it runs isap() instead; checking costs one pass over the arcs.
+ * @note Time Complexity: O(E * min(V^(2/3), E^(1/2))) for unit capacities, O(E * V^(1/2)) for bipartite matching.
+ * @param s The source node.
+ * @param t The sink node.
+ * @return The flow added on top of the current flow.
+ */
+template <typename Cap, typename Res>
+Cap BasicIsap<Cap, Res>::unit_capacity_flow(int s, int t) {
+    // One bit cannot hold a larger residual, and writing the bits back would cut it to 1.
+    if (!has_unit_capacities()) return isap(s, t);
+    if (!built) build();
+    s = inner(s);
+    t = inner(t);
+    ws.labels_valid = false;
+    ws.cut_sources.assign(1, s);
+    ws.cut_level = 0;
+    touched.clear();
+    ws.live_end.clear();
+    if (s == t) return 0;
+    int arcs = head.size();
+    vector<uint64_t> bits((arcs + 63) / 64, 0);
+    for (int a = 0; a < arcs; a++) {
+        if (ws.res[a] > 0) bits[a >> 6] |= 1ULL << (a & 63);
+    }
+    auto residual = [&](int a) { return (bits[a >> 6] >> (a & 63)) & 1; };
+    auto flip = [&](int a) {
+        bits[a >> 6] ^= 1ULL << (a & 63);
+        bits[rev[a] >> 6] ^= 1ULL << (rev[a] & 63);
+    };
+
+    Cap flow = 0;
+    vector<int>& dist = ws.level;
+    vector<int>& cur = ws.cur;
+    vector<int>& path = ws.path;
+    while (true) {
+        fill(dist.begin(), dist.end(), -1);
+        dist[s] = 0;
+        queue<int> q;
+        q.push(s);
+        while (!q.empty() && dist[t] < 0) {
+            int u = q.front();
+            q.pop();
+            for (int a = offset[u]; a < offset[u + 1]; a++) {
+                if (dist[head[a]] < 0 && residual(a)) {
+                    dist[head[a]] = dist[u] + 1;
+                    q.push(head[a]);
+                }
+            }
+        }
+        if (dist[t] < 0) break;
+        cur.assign(offset.begin(), offset.end() - 1);
+        path.clear();
+        int u = s;
+        while (true) {
+            if (u == t) {
+                for (int a : path) flip(a);
+                flow++;
+                path.clear();
+                u = s;
+                continue;
+            }
+            int& a = cur[u];
+            // Nodes as far from s as t cannot lead to it; skip their arcs.
+            if (dist[u] >= dist[t]) a = offset[u + 1];
+            while (a < offset[u + 1] && !(residual(a) && dist[head[a]] == dist[u] + 1)) a++;
+            if (a < offset[u + 1]) {
+                path.push_back(a);
+                u = head[a];
+                continue;
+            }
+            // Dead end: no path to t through u in this phase.
+            dist[u] = -1;
+            if (path.empty()) break;
+            u = head[rev[path.back()]];
+            path.pop_back();
+            cur[u]++;
+        }
+    }
+
+    for (int a = 0; a < arcs; a++) {
+        ws.res[a] = residual(a);
+    }
+    // level doubled as the distance from s; the next isap() or augment() relabels from scratch.
+    fill(ws.level.begin(), ws.level.end(), 0);
+    return flow;
+}
+
+template bool BasicIsap<int>::has_unit_capacities() const;
+template bool BasicIsap<long long>::has_unit_capacities() const;
+template bool BasicIsap<double>::has_unit_capacities() const;
+template bool BasicIsap<long long, uint32_t>::has_unit_capacities() const;
+template int BasicIsap<int>::unit_capacity_flow(int, int);
+template long long BasicIsap<long long>::unit_capacity_flow(int, int);
+template double BasicIsap<double>::unit_capacity_flow(int, int);
+template long long BasicIsap<long long, uint32_t>::unit_capacity_flow(int, int);
@@ -0,0 +1,68 @@
+#include "isap.h"
+#include <cassert>
+#include <random>
+
+int main() {
+  // Test case 1: Random bipartite matchings agree with isap()
+  mt19937 rng(1);
+  for (int round = 0; round < 30; round++) {
+    int side = 40, n = 2 * side + 2, s = n - 2, t = n - 1;
+    Isap unit(n), seq(n);
+    for (int i = 0; i < side; i++) {
+      unit.add_edge(s, i, 1);
+      seq.add_edge(s, i, 1);
+      unit.add_edge(side + i, t, 1);
+      seq.add_edge(side + i, t, 1);
+    }
+    for (int k = 0; k < 120; k++) {
+      int i = rng() % side, j = side + rng() % side;
+      unit.add_edge(i, j, 1);
+      seq.add_edge(i, j, 1);
+    }
+    assert(unit.has_unit_capacities());
+    int expected = seq.isap(s, t);
+    assert(unit.max_flow(s, t, Engine::Auto) == expected);
+    // Each left node is matched at most once, and the minimum cut matches the matching size
+    int cut = 0;
+    for (int id : unit.min_cut_edges()) cut += unit.get_edge(id).cap;
+    assert(cut == expected);
+  }
+
+  // Test case 2: General unit networks with cycles and parallel edges, continuing from an existing flow
+  for (int round = 0; round < 30; round++) {
+    int n = 30;
+    Isap unit(n), seq(n);
+    for (int k = 0; k < 150; k++) {
+      int u = rng() % n, v = rng() % n;
+      unit.add_edge(u, v, 1);
+      seq.add_edge(u, v, 1);
+    }
+    int expected = seq.isap(0, n - 1);
+    assert(unit.unit_capacity_flow(0, n - 1) == expected);
+    unit.add_edge(0, n - 1, 1);
+    unit.add_edge(0, n - 1, 1);
+    assert(unit.unit_capacity_flow(0, n - 1) == 2);
+    assert(unit.augment(0, n - 1) == 0);
+  }
+
+  // Test case 3: Engine::Auto falls back to ISAP when a capacity is not 0 or 1
+  Isap general(3);
+  general.add_edge(0, 1, 2);
+  general.add_edge(1, 2, 1);
+  assert(!general.has_unit_capacities());
+  assert(general.max_flow(0, 2, Engine::Auto) == 1);
+
+  // Test case 4: A capacity-2 edge is not cut to one bit; the engine runs ISAP instead
+  Isap wide(4);
+  wide.add_edge(0, 1, 2);
+  wide.add_edge(1, 2, 1);
+  wide.add_edge(1, 3, 1);
+  wide.add_edge(2, 3, 1);
+  assert(wide.max_flow(0, 3, Engine::UnitCapacity) == 2);
+  assert(wide.get_edge(0).cap == 2 && wide.get_edge(0).flow == 2);
+  wide.set_capacity(0, 3);
+  assert(wide.unit_capacity_flow(0, 3) == 0);
+  assert(wide.get_edge(0).cap == 3 && wide.get_edge(0).flow == 2);
+
+  return 0;
+}